@@ -1,390 +1,2205 @@
-#ifndef INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_H
-#define INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_H
-
-//////////////////////////////////////////////////////////////////////////////////////////
-//
-// Implements a string pool allocator (StringPool::Allocator) and a string class 
-// (StringPool::String) representing strings allocated with it.
-// 
-// Copyright (C) by Giovanni Dicanio
-// 
-//////////////////////////////////////////////////////////////////////////////////////////
-
-
-#include <cstdint>      // For portable int types like uint8_t
-#include <new>          // For std::bad_alloc
-#include <string>       // For std::wstring
-#include <utility>      // For std::swap
-#include <vector>       // For std::vector
-
-
-namespace StringPool 
-{
-
-// Forward declarations
-class String;
-class Allocator;
-
-
-//========================================================================================
-//                              String Class
-//========================================================================================
-
-//----------------------------------------------------------------------------------------
-// String returned by the allocator.
-// This is just made by a pointer to a C-style NUL-terminated string, 
-// and the length of that string.
-//
-// Copying this class just means member-wise copy, and it's a cheap operation.
-//
-// Do *not* delete instances of this string class: the memory of this class is managed
-// by the StringPool::Allocator, which is responsible for deleting the allocated memory
-// blocks.
-//----------------------------------------------------------------------------------------
-class String
-{
-public:
-
-    // Creates an empty string.
-    String() noexcept = default;
-
-    // Default member-wise copy is fine.
-    String(const String& other) noexcept = default;
-    String& operator=(const String& other) noexcept = default;
-
-    // Moves from the other string, leaving it empty.
-    String(String&& other) noexcept
-        : m_ptr{ other.m_ptr }
-        , m_length{ other.m_length }
-    {
-        other.m_ptr = nullptr;
-        other.m_length = 0;
-    }
-
-    // Moves from the other string, leaving it empty.
-    String& operator=(String&& other) noexcept
-    {
-        if (&other != this)
-        {
-            m_ptr = other.m_ptr;
-            other.m_ptr = nullptr;
-
-            m_length = other.m_length;
-            other.m_length = 0;
-        }
-        return *this;
-    }
-
-    // Returns C-style NUL-terminated string pointer.
-    const wchar_t* Str() const noexcept
-    {
-        if (!IsEmpty())
-        {
-            return m_ptr;
-        }
-        else
-        {
-            return &m_nul;
-        }
-    }
-
-    // Number of wchar_ts in the string (excluding the terminating NUL).
-    // An empty string has length 0.
-    size_t Length() const noexcept
-    {
-        return m_length;
-    }
-
-    bool IsEmpty() const noexcept
-    {
-        return m_length == 0;
-    }
-
-    // Convert to std::wstring.
-    std::wstring ToStdString() const
-    {
-        if (!IsEmpty())
-        {
-            return std::wstring{ m_ptr, m_length };
-        }
-        else
-        {
-            return std::wstring{};
-        }
-    }
-    
-    // Compare this with other.
-    // +1 : this > other
-    // 0  : this == other
-    // -1 : this < other
-    int Compare(const String& other) const noexcept
-    {
-        const size_t minLength = m_length < other.m_length ?
-            m_length : other.m_length;
-
-        const int result = wmemcmp(m_ptr, other.m_ptr, minLength);
-
-        if (result != 0)
-            return result;
-
-        if (m_length < other.m_length)
-            return -1;
-
-        if (m_length > other.m_length)
-            return 1;
-
-        return 0;
-    }
-
-    // StringPool::Allocator creates instances of this String class.
-    friend class Allocator;
-
-    // STL-style non-throwing swap
-    friend void swap(String& a, String& b) noexcept
-    {
-        using std::swap;
-        swap(a.m_ptr,    b.m_ptr);
-        swap(a.m_length, b.m_length);
-
-        // No need to swap m_nul, as it's always NUL for each string instance.
-    }
-
-
-private:
-    const wchar_t* m_ptr{};     // C-style raw pointer to a NUL-terminated string
-    size_t m_length{};          // Length, in wchar_ts, excluding the terminating NUL
-    
-    // The NUL character for empty strings
-    const wchar_t m_nul{};
-
-    // Constructor is private, as only the friend StringPool::Allocator class
-    // can allocate instances of this String class.
-    String(const wchar_t* ptr, size_t length) noexcept
-        : m_ptr{ ptr }
-        , m_length{ length }
-    {}
-};
-
-
-//
-// Convenient overloaded relational operators for string comparisons
-// 
-
-inline bool operator==(const String& a, const String& b) noexcept
-{
-    return a.Compare(b) == 0;
-}
-
-inline bool operator!=(const String& a, const String& b) noexcept
-{
-    return a.Compare(b) != 0;
-}
-
-inline bool operator<(const String& a, const String& b) noexcept
-{
-    return a.Compare(b) < 0;
-}
-
-inline bool operator>(const String& a, const String& b) noexcept
-{
-    return a.Compare(b) > 0;
-}
-
-inline bool operator<=(const String& a, const String& b) noexcept
-{
-    return a.Compare(b) <= 0;
-}
-
-inline bool operator>=(const String& a, const String& b) noexcept
-{
-    return a.Compare(b) >= 0;
-}
-
-
-//========================================================================================
-//                              Allocator Class
-//========================================================================================
-
-//----------------------------------------------------------------------------------------
-// String Pool Allocator
-// 
-// Preallocates chunks of memory, and serves memory just *increasing a pointer* 
-// inside a chunk.
-//----------------------------------------------------------------------------------------
-class Allocator
-{
-public:
-
-    // Initialize an empty allocator.
-    // Call AllocString when you need a new string.
-    Allocator() = default;
-
-    // Release all the allocated chunks (if any).
-    ~Allocator()
-    {
-        Clear();
-    }
-
-    // Ban copy
-    Allocator(const Allocator&) = delete;
-    Allocator& operator=(const Allocator&) = delete;
-
-    // Release every allocated chunk.
-    void Clear()
-    {
-        for (auto& pChunk : m_chunks)
-        {
-            Free(pChunk);
-            pChunk = nullptr;
-        }
-    
-        m_chunks.clear();
-
-        m_pNext = nullptr;
-        m_pLimit = nullptr;
-    }
-
-    // Allocate a string using the pool allocator, deep-copying the string
-    // from a C-style NUL-terminated string pointer.
-    // Throws std::bad_alloc on allocation failure.
-    String AllocString(const wchar_t* ptr)
-    {
-        return AllocString(ptr, ptr + wcslen(ptr));
-    }
-
-    // Allocate a string using the pool allocator, deep-copying the string
-    // from a [start, finish) "string view".
-    // As per the STL convention: start is included, finish is excluded.
-    // Throws std::bad_alloc on allocation failure.
-    String AllocString(const wchar_t* start, const wchar_t* finish)
-    {
-        const size_t length = finish - start;
-        const size_t lengthWithNul = length + 1;
-        wchar_t* ptr = AllocMemory(lengthWithNul);
-        wmemcpy(ptr, start, length);
-        ptr[length] = L'\0'; // terminating NUL
-
-        return String{ ptr, length };
-    }
-
-
-private:
-
-    // A memory chunk is made by this header followed by the allocated wchar_ts.
-    struct ChunkHeader 
-    {
-        // Total chunk size, in bytes
-        size_t SizeInBytes;
-
-        // Followed by array of wchar_t characters 
-        wchar_t Chars[1];
-    };
-
-    enum 
-    {
-        // An allocated chunk must be minimum this size, in bytes
-        kMinChunkSizeInBytes = 600000,
-
-        // Can't alloc strings larger than that (in wchar_ts)
-        kMaxStringLength = 1024 * 1024
-    };
-
-
-    wchar_t*  m_pNext{};    // First available wchar_t slot in the current chunk
-    wchar_t*  m_pLimit{};   // One past last available wchar_t slot in the current chunk
-
-    // Keep a list of all allocated chunks.
-    // NOTE: ChunkHeader pointers are *owning* raw pointers, 
-    // that will be released by this class destructor.
-    std::vector<ChunkHeader*> m_chunks{};
-
-
-    //------------------------------------------------------------------------------------
-    // Helper Methods
-    //------------------------------------------------------------------------------------
-
-
-    //
-    // Helper functions to allocate and free memory.
-    // Those could be factored out as a trait class, to experiment with pool allocators
-    // using different alloc/free techniques/APIs.
-    // 
-
-    // Request a memory allocation.
-    // Return nullptr on failure.
-    static void* Allocate(size_t cbSize) noexcept
-    {
-        return malloc(cbSize);
-    }
-
-    // Free a previous allocation.
-    static void Free(void* ptr) noexcept
-    {
-        return free(ptr);
-    }
-
-    // Helper function to allocate memory using the pool allocator.
-    // 'length' is the number of wchar_ts requested.
-    // 
-    // First tries to carve memory from the current chunk.
-    // If there's not enough space, allocates a new chunk.
-    // Throws std::bad_alloc on allocation errors.
-    wchar_t* AllocMemory(size_t length)
-    {      
-        // First let's try allocation in current chunk
-        wchar_t* ptr = m_pNext;
-        if (m_pNext + length <= m_pLimit)
-        {
-            // There's enough room in current chunk, so a simple pointer increase will do!
-            m_pNext += length;
-            return ptr;
-        }
-
-        // There's not enough room in current chunk. We need to allocate a new chunk.
-
-        // Prevent request of too long strings
-        if (length > kMaxStringLength)
-        {
-            throw std::bad_alloc();
-        }
-
-        // Allocate a new chunk, not smaller than minimum chunk size
-        size_t chunkSizeInBytes = (length * sizeof(wchar_t)) + sizeof(ChunkHeader);
-        if (chunkSizeInBytes < kMinChunkSizeInBytes)
-        {
-            chunkSizeInBytes = kMinChunkSizeInBytes;
-        }
-
-        uint8_t* pChunkStart = static_cast<uint8_t*>(Allocate(chunkSizeInBytes));
-        if (pChunkStart == nullptr)
-        {
-            // Allocation failure: throw std::bad_alloc
-            static std::bad_alloc outOfMemory;
-            throw outOfMemory;
-        }
-
-        // Point one past the last available wchar_t in current chunk
-        m_pLimit = reinterpret_cast<wchar_t*>(pChunkStart + chunkSizeInBytes);
-
-        // Prepare the chunk header
-        ChunkHeader* pNewChunk = reinterpret_cast<ChunkHeader*>(pChunkStart);
-        pNewChunk->SizeInBytes = chunkSizeInBytes;
-        
-        // Set the pointer to point to the free bytes to serve the next allocation
-        m_pNext = reinterpret_cast<wchar_t*>(pNewChunk + 1);
-
-        // Keep track of the newly allocated chunk,
-        // adding it to the chunk pointer vector
-        m_chunks.push_back(pNewChunk);
-
-        // Now that we have allocated a new chunk, 
-        // we can retry the allocation with a simple pointer increase
-        return AllocMemory(length);
-    }
-};
-
-
-} // namespace StringPool
-
-
-#endif // INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_H
+#ifndef INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_H
+#define INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_H
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//
+// Implements a string pool allocator (StringPool::Allocator) and a string class 
+// (StringPool::String) representing strings allocated with it.
+//
+// Both are class templates over the character type (BasicAllocator and BasicString): 
+// StringPool::Allocator and StringPool::String use wchar_t, and there are aliases
+// for pools of char, char8_t (C++20), char16_t and char32_t strings as well.
+// 
+// Copyright (C) by Giovanni Dicanio
+// 
+//////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <chrono>       // For timing the chunk allocation slow path
+#include <cstddef>      // For std::max_align_t
+#include <cstdint>      // For portable int types like uint8_t
+#include <cstdlib>      // For malloc, free, std::abort
+#include <cstring>      // For memcmp, memset, strlen
+#if defined(_MSC_VER)
+#include <malloc.h>     // For _expand
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>   // For mmap, munmap
+#include <unistd.h>     // For sysconf
+#define STRINGPOOL_HAS_MAPPED_CHUNKS
+#endif
+#include <exception>    // For std::exception
+#include <functional>   // For std::function
+#include <iosfwd>       // For std::basic_ostream
+#include <new>          // For std::bad_alloc
+#include <string>       // For std::basic_string, std::char_traits
+#include <type_traits>  // For std::true_type
+#include <utility>      // For std::swap
+#include <vector>       // For std::vector
+
+#include "StringPoolSimd.h"
+#include "StringPoolUtf8.h"
+#include "StringPoolCaseFold.h"
+
+#if (defined(_MSVC_LANG) ? _MSVC_LANG : __cplusplus) >= 201703L && defined(__has_include)
+#if __has_include(<string_view>)
+#include <string_view>  // For std::basic_string_view
+#endif
+#endif
+
+// STRINGPOOL_HAS_STRING_VIEW is defined when the std::basic_string_view interop 
+// (C++17) is available.
+#if defined(__cpp_lib_string_view)
+#define STRINGPOOL_HAS_STRING_VIEW
+#endif
+
+
+// Define STRINGPOOL_NO_EXCEPTIONS to build without exceptions: in this case, 
+// the throwing allocation functions abort on failure, and the TryXxx functions 
+// should be used instead.
+// This is automatically detected when exceptions are disabled in the compiler.
+#if !defined(STRINGPOOL_NO_EXCEPTIONS) \
+    && !defined(__cpp_exceptions) && !defined(__EXCEPTIONS) && !defined(_CPPUNWIND)
+#define STRINGPOOL_NO_EXCEPTIONS
+#endif
+
+
+namespace StringPool 
+{
+
+// Forward declarations
+template <typename CharT> class BasicString;
+struct NoInstrumentation;
+template <typename CharT, typename Instrumentation = NoInstrumentation> 
+class BasicAllocator;
+template <typename CharT> class BasicSnapshot;
+template <typename CharT> class BasicSharedPool;
+
+// The default pooled string, and string pool allocator (with no instrumentation 
+// overhead), using wchar_t.
+using String = BasicString<wchar_t>;
+using Allocator = BasicAllocator<wchar_t>;
+
+// Pooled strings and allocators for the other character types.
+// Note that wchar_t is 4 bytes on Linux and macOS, so e.g. UTF-16 or UTF-8 pools
+// take half or a quarter of the memory for mostly-ASCII text there.
+using NarrowString = BasicString<char>;
+using NarrowAllocator = BasicAllocator<char>;
+
+#if defined(__cpp_char8_t)
+using U8String = BasicString<char8_t>;
+using U8Allocator = BasicAllocator<char8_t>;
+#endif
+
+using U16String = BasicString<char16_t>;
+using U16Allocator = BasicAllocator<char16_t>;
+
+using U32String = BasicString<char32_t>;
+using U32Allocator = BasicAllocator<char32_t>;
+
+
+//========================================================================================
+//                              String Class
+//========================================================================================
+
+//----------------------------------------------------------------------------------------
+// String returned by the allocator.
+// This is just made by a pointer to a C-style NUL-terminated string, 
+// and the length of that string.
+//
+// Copying this class just means member-wise copy, and it's a cheap operation.
+//
+// Do *not* delete instances of this string class: the memory of this class is managed
+// by the StringPool::Allocator, which is responsible for deleting the allocated memory
+// blocks.
+//
+// CharT is the character type (char, char8_t, char16_t, char32_t or wchar_t).
+//----------------------------------------------------------------------------------------
+template <typename CharT>
+class BasicString
+{
+public:
+
+    // The character type of this string
+    typedef CharT CharType;
+
+    // Creates an empty string.
+    BasicString() noexcept = default;
+
+    // Default member-wise copy is fine.
+    BasicString(const BasicString& other) noexcept = default;
+    BasicString& operator=(const BasicString& other) noexcept = default;
+
+    // Moves from the other string, leaving it empty.
+    BasicString(BasicString&& other) noexcept
+        : m_ptr{ other.m_ptr }
+        , m_length{ other.m_length }
+    {
+        other.m_ptr = nullptr;
+        other.m_length = 0;
+    }
+
+    // Moves from the other string, leaving it empty.
+    BasicString& operator=(BasicString&& other) noexcept
+    {
+        if (&other != this)
+        {
+            m_ptr = other.m_ptr;
+            other.m_ptr = nullptr;
+
+            m_length = other.m_length;
+            other.m_length = 0;
+        }
+        return *this;
+    }
+
+    // Returns C-style NUL-terminated string pointer.
+    const CharT* Str() const noexcept
+    {
+        if (!IsEmpty())
+        {
+            return m_ptr;
+        }
+        else
+        {
+            return &m_nul;
+        }
+    }
+
+    // Number of characters in the string (excluding the terminating NUL).
+    // An empty string has length 0.
+    size_t Length() const noexcept
+    {
+        return m_length;
+    }
+
+    bool IsEmpty() const noexcept
+    {
+        return m_length == 0;
+    }
+
+    // Convert to std::basic_string (e.g. std::wstring for StringPool::String).
+    std::basic_string<CharT> ToStdString() const
+    {
+        if (!IsEmpty())
+        {
+            return std::basic_string<CharT>{ m_ptr, m_length };
+        }
+        else
+        {
+            return std::basic_string<CharT>{};
+        }
+    }
+
+#ifdef STRINGPOOL_HAS_STRING_VIEW
+
+    // View on the pooled characters, with no copy 
+    // (e.g. std::wstring_view for StringPool::String).
+    // The view is valid as long as the string memory is (i.e. until the allocator
+    // is cleared or destroyed).
+    std::basic_string_view<CharT> View() const noexcept
+    {
+        return std::basic_string_view<CharT>{ Str(), m_length };
+    }
+
+    // Implicit conversion to std::basic_string_view, to pass pooled strings to 
+    // functions taking views with no copy.
+    operator std::basic_string_view<CharT>() const noexcept
+    {
+        return View();
+    }
+
+#endif // STRINGPOOL_HAS_STRING_VIEW
+    
+    // Compare this with other.
+    // +1 : this > other
+    // 0  : this == other
+    // -1 : this < other
+    //
+    // The characters are compared with a SIMD kernel (selected at runtime 
+    // for the current CPU), in the order of std::char_traits<CharT>, 
+    // like std::basic_string (e.g. as unsigned bytes for char).
+    int Compare(const BasicString& other) const noexcept
+    {
+        return CompareWith(other.m_ptr, other.m_length);
+    }
+
+    // Check if this is equal to other.
+    // Faster than Compare: strings with different lengths are never equal,
+    // and strings pointing to the same characters always are.
+    bool Equals(const BasicString& other) const noexcept
+    {
+        if (m_length != other.m_length)
+            return false;
+
+        // (Empty strings may have a null pointer, that can't be passed to memcmp)
+        if (m_ptr == other.m_ptr || m_length == 0)
+            return true;
+
+        return memcmp(m_ptr, other.m_ptr, m_length * sizeof(CharT)) == 0;
+    }
+
+#ifdef STRINGPOOL_HAS_STRING_VIEW
+
+    // Compare this with a string view (same results as Compare above).
+    int Compare(std::basic_string_view<CharT> other) const noexcept
+    {
+        return CompareWith(other.data(), other.size());
+    }
+
+    // Check if this is equal to a string view.
+    bool Equals(std::basic_string_view<CharT> other) const noexcept
+    {
+        if (m_length != other.size())
+            return false;
+
+        return m_length == 0 
+            || memcmp(m_ptr, other.data(), m_length * sizeof(CharT)) == 0;
+    }
+
+#endif // STRINGPOOL_HAS_STRING_VIEW
+
+    // StringPool::BasicAllocator creates instances of this string class.
+    template <typename C, typename Instrumentation> friend class BasicAllocator;
+
+    // StringPool::BasicSnapshot and StringPool::BasicSharedPool create instances 
+    // pointing into mapped files and shared memory.
+    template <typename C> friend class BasicSnapshot;
+    template <typename C> friend class BasicSharedPool;
+
+    // STL-style non-throwing swap
+    friend void swap(BasicString& a, BasicString& b) noexcept
+    {
+        using std::swap;
+        swap(a.m_ptr,    b.m_ptr);
+        swap(a.m_length, b.m_length);
+
+        // No need to swap m_nul, as it's always NUL for each string instance.
+    }
+
+
+private:
+    const CharT* m_ptr{};       // C-style raw pointer to a NUL-terminated string
+    size_t m_length{};          // Length, in characters, excluding the terminating NUL
+    
+    // The NUL character for empty strings
+    const CharT m_nul{};
+
+    // Constructor is private, as only the friend StringPool::BasicAllocator class
+    // can allocate instances of this string class.
+    BasicString(const CharT* ptr, size_t length) noexcept
+        : m_ptr{ ptr }
+        , m_length{ length }
+    {}
+
+    // Compare this with the 'length' characters pointed by 'ptr'.
+    int CompareWith(const CharT* ptr, size_t length) const noexcept
+    {
+        const size_t minLength = m_length < length ? m_length : length;
+
+        const int result = Detail::CompareChars(m_ptr, ptr, minLength);
+
+        if (result != 0)
+            return result;
+
+        if (m_length < length)
+            return -1;
+
+        if (m_length > length)
+            return 1;
+
+        return 0;
+    }
+};
+
+
+//
+// Convenient overloaded relational operators for string comparisons
+// 
+
+template <typename CharT>
+inline bool operator==(const BasicString<CharT>& a, const BasicString<CharT>& b) noexcept
+{
+    return a.Equals(b);
+}
+
+template <typename CharT>
+inline bool operator!=(const BasicString<CharT>& a, const BasicString<CharT>& b) noexcept
+{
+    return !a.Equals(b);
+}
+
+template <typename CharT>
+inline bool operator<(const BasicString<CharT>& a, const BasicString<CharT>& b) noexcept
+{
+    return a.Compare(b) < 0;
+}
+
+template <typename CharT>
+inline bool operator>(const BasicString<CharT>& a, const BasicString<CharT>& b) noexcept
+{
+    return a.Compare(b) > 0;
+}
+
+template <typename CharT>
+inline bool operator<=(const BasicString<CharT>& a, const BasicString<CharT>& b) noexcept
+{
+    return a.Compare(b) <= 0;
+}
+
+template <typename CharT>
+inline bool operator>=(const BasicString<CharT>& a, const BasicString<CharT>& b) noexcept
+{
+    return a.Compare(b) >= 0;
+}
+
+
+#ifdef STRINGPOOL_HAS_STRING_VIEW
+
+//
+// Heterogeneous relational operators between pooled strings and string views, 
+// e.g. for lookups in containers with transparent comparators (std::less<>) with 
+// no temporary std::wstring.
+// 
+// The view side is a non-deduced parameter, so anything convertible to a view
+// (std::basic_string, string literals) works too.
+//
+
+namespace Detail
+{
+    // Blocks template argument deduction on T.
+    template <typename T>
+    struct NonDeduced
+    {
+        typedef T Type;
+    };
+
+    template <typename CharT>
+    using ViewOf = typename NonDeduced<std::basic_string_view<CharT>>::Type;
+} // namespace Detail
+
+template <typename CharT>
+inline bool operator==(const BasicString<CharT>& a, Detail::ViewOf<CharT> b) noexcept
+{
+    return a.Equals(b);
+}
+
+template <typename CharT>
+inline bool operator==(Detail::ViewOf<CharT> a, const BasicString<CharT>& b) noexcept
+{
+    return b.Equals(a);
+}
+
+template <typename CharT>
+inline bool operator!=(const BasicString<CharT>& a, Detail::ViewOf<CharT> b) noexcept
+{
+    return !a.Equals(b);
+}
+
+template <typename CharT>
+inline bool operator!=(Detail::ViewOf<CharT> a, const BasicString<CharT>& b) noexcept
+{
+    return !b.Equals(a);
+}
+
+template <typename CharT>
+inline bool operator<(const BasicString<CharT>& a, Detail::ViewOf<CharT> b) noexcept
+{
+    return a.Compare(b) < 0;
+}
+
+template <typename CharT>
+inline bool operator<(Detail::ViewOf<CharT> a, const BasicString<CharT>& b) noexcept
+{
+    return b.Compare(a) > 0;
+}
+
+template <typename CharT>
+inline bool operator>(const BasicString<CharT>& a, Detail::ViewOf<CharT> b) noexcept
+{
+    return a.Compare(b) > 0;
+}
+
+template <typename CharT>
+inline bool operator>(Detail::ViewOf<CharT> a, const BasicString<CharT>& b) noexcept
+{
+    return b.Compare(a) < 0;
+}
+
+template <typename CharT>
+inline bool operator<=(const BasicString<CharT>& a, Detail::ViewOf<CharT> b) noexcept
+{
+    return a.Compare(b) <= 0;
+}
+
+template <typename CharT>
+inline bool operator<=(Detail::ViewOf<CharT> a, const BasicString<CharT>& b) noexcept
+{
+    return b.Compare(a) >= 0;
+}
+
+template <typename CharT>
+inline bool operator>=(const BasicString<CharT>& a, Detail::ViewOf<CharT> b) noexcept
+{
+    return a.Compare(b) >= 0;
+}
+
+template <typename CharT>
+inline bool operator>=(Detail::ViewOf<CharT> a, const BasicString<CharT>& b) noexcept
+{
+    return b.Compare(a) <= 0;
+}
+
+// Write the string to an output stream (e.g. for logging), with no copy.
+template <typename CharT, typename Traits>
+inline std::basic_ostream<CharT, Traits>& operator<<(
+    std::basic_ostream<CharT, Traits>& os, const BasicString<CharT>& s)
+{
+    return os << s.View();
+}
+
+#endif // STRINGPOOL_HAS_STRING_VIEW
+
+
+//
+// UTF-8 export of pooled strings (see also BasicAllocator::AllocStringFromUtf8)
+// 
+
+// Append the UTF-8 encoding of the string to 'utf8'.
+// UTF-16 and UTF-32 strings are transcoded, with unpaired surrogates and invalid 
+// code points exported as U+FFFD; strings of 1-byte characters are copied as they are.
+template <typename CharT>
+void AppendUtf8(const BasicString<CharT>& s, std::string& utf8)
+{
+    // Size the output with an upper bound, and trim it after the transcoding
+    const size_t oldSize = utf8.size();
+    utf8.resize(oldSize + Detail::MaxUtf8Length<CharT>(s.Length()));
+
+    const size_t written = Detail::TranscodeToUtf8(s.Str(), s.Length(), &utf8[oldSize], 
+                                                   Detail::EncodingOf<CharT>{});
+    utf8.resize(oldSize + written);
+}
+
+// Return the UTF-8 encoding of the string (see AppendUtf8).
+template <typename CharT>
+std::string ToUtf8(const BasicString<CharT>& s)
+{
+    std::string utf8;
+    AppendUtf8(s, utf8);
+    return utf8;
+}
+
+
+//
+// Case-insensitive comparisons, based on the Unicode simple case folding
+// (see also BasicAllocator::AllocStringFolded)
+// 
+
+// Compare two strings ignoring case.
+// +1 : a > b
+// 0  : a == b
+// -1 : a < b
+//
+// The strings are compared by their folded code points, in code point order.
+template <typename CharT>
+int CompareIgnoreCase(const BasicString<CharT>& a, const BasicString<CharT>& b) noexcept
+{
+    return Detail::CompareFolded(a.Str(), a.Length(), b.Str(), b.Length());
+}
+
+// Case-insensitive "less than" functor, e.g. for std::map or std::sort.
+struct CaseInsensitiveLess
+{
+    template <typename CharT>
+    bool operator()(const BasicString<CharT>& a, const BasicString<CharT>& b) const noexcept
+    {
+        return CompareIgnoreCase(a, b) < 0;
+    }
+};
+
+// Case-insensitive equality functor, e.g. for std::unordered_map
+// (together with CaseInsensitiveHash).
+struct CaseInsensitiveEqual
+{
+    template <typename CharT>
+    bool operator()(const BasicString<CharT>& a, const BasicString<CharT>& b) const noexcept
+    {
+        return CompareIgnoreCase(a, b) == 0;
+    }
+};
+
+// Case-insensitive hash functor: strings that are equal ignoring case 
+// have the same hash.
+struct CaseInsensitiveHash
+{
+    template <typename CharT>
+    size_t operator()(const BasicString<CharT>& s) const noexcept
+    {
+        return Detail::HashFolded(s.Str(), s.Length());
+    }
+};
+
+
+//========================================================================================
+//                              Instrumentation Policies
+//========================================================================================
+
+//----------------------------------------------------------------------------------------
+// The allocator notifies its instrumentation policy of:
+//
+//  - every string allocation:                  OnAllocString(length)
+//  - the beginning of the chunk allocation:    OnChunkAllocStart()
+//  - the end of the chunk allocation:          OnChunkAllocFinish(chunkSizeInBytes)
+//
+// The last two calls bracket the slow path of StringPool::Allocator, 
+// when a new chunk must be allocated.
+//
+// The allocator privately derives from its policy class, so an empty policy 
+// doesn't take any space, and its empty inline methods are optimized away.
+//----------------------------------------------------------------------------------------
+
+// Default policy: no instrumentation at all (zero overhead).
+struct NoInstrumentation
+{
+    void OnAllocString(size_t /* length */) noexcept {}
+    void OnChunkAllocStart() noexcept {}
+    void OnChunkAllocFinish(size_t /* chunkSizeInBytes */) noexcept {}
+};
+
+
+//----------------------------------------------------------------------------------------
+// Callback interface to receive the data collected by HistogramInstrumentation,
+// e.g. to wire it into a metrics system.
+// Override the methods you are interested in.
+//----------------------------------------------------------------------------------------
+class InstrumentationCallback
+{
+public:
+    virtual ~InstrumentationCallback() = default;
+
+    // Called after each new chunk is allocated, with the time spent in the slow path.
+    virtual void OnChunkAllocated(size_t /* chunkSizeInBytes */,
+                                  std::chrono::nanoseconds /* elapsed */) 
+    {}
+
+    // Called by HistogramInstrumentation::ReportHistogram for each non-empty bucket.
+    virtual void OnStringLengthBucket(size_t /* bucket */, uint64_t /* count */) 
+    {}
+};
+
+
+//----------------------------------------------------------------------------------------
+// Instrumentation policy that records a log2 histogram of the allocated string lengths,
+// and times the chunk allocation slow path.
+//
+// Bucket 0 counts empty strings; bucket i (for i >= 1) counts strings 
+// whose length is in the [2^(i-1), 2^i) range.
+//----------------------------------------------------------------------------------------
+class HistogramInstrumentation
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    enum
+    {
+        kBucketCount = (8 * sizeof(size_t)) + 1
+    };
+
+    // Set the callback to be notified of instrumentation events (can be nullptr).
+    // The callback is *observed*, not owned.
+    void SetCallback(InstrumentationCallback* pCallback) noexcept
+    {
+        m_pCallback = pCallback;
+    }
+
+    // Return the histogram bucket for a given string length.
+    static size_t BucketIndex(size_t length) noexcept
+    {
+        size_t bucket = 0;
+        while (length != 0)
+        {
+            ++bucket;
+            length >>= 1;
+        }
+        return bucket;
+    }
+
+    // Number of allocated strings in the given histogram bucket.
+    uint64_t BucketCount(size_t bucket) const noexcept
+    {
+        return m_buckets[bucket];
+    }
+
+    // Number of chunks allocated so far.
+    uint64_t ChunkAllocCount() const noexcept
+    {
+        return m_chunkAllocCount;
+    }
+
+    // Total time spent in the chunk allocation slow path.
+    std::chrono::nanoseconds SlowPathTime() const noexcept
+    {
+        return m_slowPathTime;
+    }
+
+    // Invoke the callback (if any) for each non-empty bucket of the histogram.
+    void ReportHistogram() const
+    {
+        if (m_pCallback == nullptr)
+        {
+            return;
+        }
+
+        for (size_t bucket = 0; bucket < kBucketCount; ++bucket)
+        {
+            if (m_buckets[bucket] != 0)
+            {
+                m_pCallback->OnStringLengthBucket(bucket, m_buckets[bucket]);
+            }
+        }
+    }
+
+    // Clear the collected data (the callback is preserved).
+    void Reset() noexcept
+    {
+        for (auto& count : m_buckets)
+        {
+            count = 0;
+        }
+
+        m_chunkAllocCount = 0;
+        m_slowPathTime = std::chrono::nanoseconds::zero();
+    }
+
+    //
+    // Instrumentation policy interface
+    //
+
+    void OnAllocString(size_t length) noexcept
+    {
+        ++m_buckets[BucketIndex(length)];
+    }
+
+    void OnChunkAllocStart() noexcept
+    {
+        m_slowPathStart = Clock::now();
+    }
+
+    void OnChunkAllocFinish(size_t chunkSizeInBytes)
+    {
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - m_slowPathStart);
+
+        ++m_chunkAllocCount;
+        m_slowPathTime += elapsed;
+
+        if (m_pCallback != nullptr)
+        {
+            m_pCallback->OnChunkAllocated(chunkSizeInBytes, elapsed);
+        }
+    }
+
+private:
+    uint64_t m_buckets[kBucketCount]{};
+    uint64_t m_chunkAllocCount{};
+    std::chrono::nanoseconds m_slowPathTime{};
+    Clock::time_point m_slowPathStart{};
+
+    InstrumentationCallback* m_pCallback{};     // Observing pointer
+};
+
+
+//========================================================================================
+//                              Allocator Class
+//========================================================================================
+
+//----------------------------------------------------------------------------------------
+// Reasons for allocation failures, reported by the non-throwing allocation functions.
+//----------------------------------------------------------------------------------------
+enum class AllocError
+{
+    None,               // No error
+    OutOfMemory,        // The system memory allocator failed
+    StringTooLong,      // The requested string is too long for the pool allocator
+    BudgetExceeded,     // The allocation would exceed the allocator's hard memory limit
+    InvalidUtf8         // The source string is not valid UTF-8
+};
+
+
+//----------------------------------------------------------------------------------------
+// Result of the non-throwing allocation functions (like BasicAllocator::TryAllocString).
+// Holds either the allocated string, or the reason of the allocation failure.
+//----------------------------------------------------------------------------------------
+template <typename CharT>
+class BasicAllocResult
+{
+public:
+    // Successful allocation
+    explicit BasicAllocResult(const BasicString<CharT>& str) noexcept
+        : m_string{ str }
+    {}
+
+    // Failed allocation
+    explicit BasicAllocResult(AllocError error) noexcept
+        : m_error{ error }
+    {}
+
+    bool HasValue() const noexcept
+    {
+        return m_error == AllocError::None;
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return HasValue();
+    }
+
+    // The allocated string. 
+    // On failure, this is an empty string.
+    const BasicString<CharT>& Value() const noexcept
+    {
+        return m_string;
+    }
+
+    AllocError Error() const noexcept
+    {
+        return m_error;
+    }
+
+private:
+    BasicString<CharT> m_string{};
+    AllocError m_error{ AllocError::None };
+};
+
+// Result of the non-throwing allocation functions of StringPool::Allocator.
+using AllocResult = BasicAllocResult<wchar_t>;
+
+
+//----------------------------------------------------------------------------------------
+// Exception thrown when an allocation would exceed the allocator's hard memory limit
+// (see BasicAllocator::SetBudget).
+// Derives from std::bad_alloc, so existing out-of-memory handlers still apply.
+//----------------------------------------------------------------------------------------
+class BudgetExceeded : public std::bad_alloc
+{
+public:
+    const char* what() const noexcept override
+    {
+        return "StringPool: memory budget exceeded";
+    }
+};
+
+
+//----------------------------------------------------------------------------------------
+// Exception thrown when the source of BasicAllocator::AllocStringFromUtf8 
+// is not valid UTF-8.
+//----------------------------------------------------------------------------------------
+class InvalidUtf8 : public std::exception
+{
+public:
+    const char* what() const noexcept override
+    {
+        return "StringPool: invalid UTF-8 sequence";
+    }
+};
+
+
+//----------------------------------------------------------------------------------------
+// String Pool Allocator
+// 
+// Preallocates chunks of memory, and serves memory just *increasing a pointer* 
+// inside a chunk.
+//
+// CharT is the character type of the allocated strings, and the Instrumentation 
+// template parameter is the instrumentation policy 
+// (see NoInstrumentation and HistogramInstrumentation).
+// StringPool::Allocator is the CharT allocator with no instrumentation.
+//----------------------------------------------------------------------------------------
+template <typename CharT, typename Instrumentation>
+class BasicAllocator : private Instrumentation
+{
+public:
+
+    // The types of the strings served by this allocator
+    typedef CharT CharType;
+    typedef BasicString<CharT> String;
+    typedef BasicAllocResult<CharT> AllocResult;
+
+    // Initialize an empty allocator.
+    // Call AllocString when you need a new string.
+    BasicAllocator() = default;
+
+    // Release all the allocated chunks (if any).
+    ~BasicAllocator()
+    {
+        Clear();
+    }
+
+    // Ban copy
+    BasicAllocator(const BasicAllocator&) = delete;
+    BasicAllocator& operator=(const BasicAllocator&) = delete;
+
+    // Move the chunks (and the settings) from the other allocator, 
+    // leaving it empty, as if default-constructed.
+    // The strings allocated by the other allocator remain valid, and are now owned
+    // by this allocator (StlAllocator and MemoryResource objects instead keep 
+    // referring to the other allocator object).
+    BasicAllocator(BasicAllocator&& other) noexcept
+    {
+        swap(*this, other);
+    }
+
+    // Release the chunks of this allocator, and move the chunks (and the settings) 
+    // from the other allocator, leaving it empty, as if default-constructed.
+    BasicAllocator& operator=(BasicAllocator&& other) noexcept
+    {
+        if (&other != this)
+        {
+            BasicAllocator temp{ std::move(other) };
+            swap(*this, temp);
+        }
+        return *this;
+    }
+
+    // STL-style non-throwing swap
+    friend void swap(BasicAllocator& a, BasicAllocator& b) noexcept
+    {
+        using std::swap;
+        swap(static_cast<Instrumentation&>(a), static_cast<Instrumentation&>(b));
+
+        swap(a.m_pNext,  b.m_pNext);
+        swap(a.m_pLimit, b.m_pLimit);
+        swap(a.m_chunks, b.m_chunks);
+
+        swap(a.m_allocatedBytes,     b.m_allocatedBytes);
+        swap(a.m_softLimitInBytes,   b.m_softLimitInBytes);
+        swap(a.m_hardLimitInBytes,   b.m_hardLimitInBytes);
+        swap(a.m_softLimitNotified,  b.m_softLimitNotified);
+        swap(a.m_softLimitCallback,  b.m_softLimitCallback);
+
+        swap(a.m_tailPaddingInBytes, b.m_tailPaddingInBytes);
+        swap(a.m_alignmentMask,      b.m_alignmentMask);
+    }
+
+    // Take ownership of all the chunks of the other allocator, with no string copies
+    // (e.g. to merge per-thread pools into a global one): the strings allocated 
+    // by the other allocator remain valid, and are now released by this allocator.
+    // The other allocator is left empty (like after Clear), and its settings 
+    // are preserved.
+    // 
+    // The chunk pointers are spliced in O(chunks). This allocator keeps serving
+    // allocations from its current chunk, so the unused tail of the other allocator's
+    // current chunk is wasted (ShrinkToFit it before, to release it).
+    // The absorbed chunks count towards the memory budget (see SetBudget), 
+    // but Absorb never fails because of it; the instrumentation data is not merged.
+    // 
+    // Throws std::bad_alloc if the chunk list can't be grown, leaving both allocators 
+    // unchanged (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    void Absorb(BasicAllocator&& other)
+    {
+        if (&other == this || other.m_chunks.empty())
+        {
+            return;
+        }
+
+        if (m_chunks.empty())
+        {
+            // Just take the other chunk list
+            m_chunks.swap(other.m_chunks);
+        }
+        else
+        {
+            m_chunks.reserve(m_chunks.size() + other.m_chunks.size());
+
+            // The current chunk (if any) must stay the last one (see ShrinkToFit)
+            const auto position = (m_pNext != nullptr) ? 
+                (m_chunks.end() - 1) : m_chunks.end();
+            m_chunks.insert(position, other.m_chunks.begin(), other.m_chunks.end());
+            other.m_chunks.clear();
+        }
+
+        m_allocatedBytes += other.m_allocatedBytes;
+
+        other.m_pNext = nullptr;
+        other.m_pLimit = nullptr;
+        other.m_allocatedBytes = 0;
+        other.m_softLimitNotified = false;
+
+        NotifySoftLimit();
+    }
+
+    // Function invoked when the allocated memory crosses the soft limit.
+    // Receives the total allocated bytes and the soft limit, in bytes.
+    typedef std::function<void(size_t allocatedBytes, size_t softLimitInBytes)> 
+        SoftLimitCallback;
+
+    // Set a memory budget for the chunks allocated by this allocator.
+    // 
+    // When the total chunk memory crosses softLimitInBytes, the callback is invoked
+    // once (until the next call to Clear or SetBudget).
+    // An allocation that would make the total chunk memory exceed hardLimitInBytes
+    // fails: AllocString throws StringPool::BudgetExceeded, and TryAllocString
+    // returns AllocError::BudgetExceeded.
+    //
+    // Pass 0 to disable a limit. Budget checks only happen when a new chunk 
+    // is allocated, so the pointer-increase fast path is unaffected.
+    void SetBudget(size_t softLimitInBytes, size_t hardLimitInBytes,
+                   SoftLimitCallback softLimitCallback = nullptr)
+    {
+        m_softLimitInBytes = softLimitInBytes;
+        m_hardLimitInBytes = hardLimitInBytes;
+        m_softLimitCallback = std::move(softLimitCallback);
+        m_softLimitNotified = false;
+    }
+
+    // Total bytes of the chunks currently allocated by this allocator.
+    size_t AllocatedBytes() const noexcept
+    {
+        return m_allocatedBytes;
+    }
+
+    //
+    // Chunk layout options for SIMD kernels.
+    //
+    // Over-read contract: with a tail padding of P bytes, for every *non-empty* String s
+    // allocated after the call to SetTailPadding, the bytes in the range
+    //
+    //      [ s.Str(), s.Str() + s.Length() + 1 ) followed by P more bytes
+    //
+    // are readable, so SIMD kernels can load 'P' bytes past the terminating NUL
+    // without bounds checks. When any of these options is set, the new chunks are 
+    // zero-filled: the bytes after the NUL are zeros up to the start of the next 
+    // string (the alignment padding), or up to the end of the chunk (the tail padding);
+    // anyway, kernels reading past the end of a string must mask the following
+    // strings out.
+    // Empty strings don't point into the pool: Str() returns a NUL stored 
+    // in the String itself, so they must be handled separately.
+    //
+    // Both options take effect for the following allocations: if a chunk is already 
+    // in use, the next allocation starts a new chunk.
+    //
+
+    // Guarantee at least 'paddingInBytes' readable bytes after the end 
+    // of each string (e.g. 64 for AVX-512 kernels).
+    void SetTailPadding(size_t paddingInBytes) noexcept
+    {
+        // Keep the chunk limit aligned on a character boundary
+        m_tailPaddingInBytes = (paddingInBytes + sizeof(CharT) - 1) 
+            & ~(sizeof(CharT) - 1);
+
+        // Close the current chunk
+        m_pLimit = m_pNext;
+    }
+
+    // Align the start of each string to 'alignmentInBytes', rounded up to a power 
+    // of two not smaller than sizeof(CharT) (e.g. 32 for aligned AVX2 loads).
+    // Each string takes a multiple of the alignment in the pool.
+    void SetStringAlignment(size_t alignmentInBytes) noexcept
+    {
+        size_t alignment = sizeof(CharT);
+        while (alignment < alignmentInBytes)
+        {
+            alignment *= 2;
+        }
+
+        m_alignmentMask = (alignment / sizeof(CharT)) - 1;
+
+        // Close the current chunk
+        m_pLimit = m_pNext;
+    }
+
+    // Access the instrumentation policy object.
+    Instrumentation& GetInstrumentation() noexcept
+    {
+        return *this;
+    }
+
+    const Instrumentation& GetInstrumentation() const noexcept
+    {
+        return *this;
+    }
+
+    // Release every allocated chunk.
+    void Clear()
+    {
+        for (auto& pChunk : m_chunks)
+        {
+            FreeChunk(pChunk);
+            pChunk = nullptr;
+        }
+    
+        m_chunks.clear();
+
+        m_pNext = nullptr;
+        m_pLimit = nullptr;
+
+        m_allocatedBytes = 0;
+        m_softLimitNotified = false;
+    }
+
+    // Make sure that the next 'expectedStrings' strings, made by 'totalChars' 
+    // characters in total (excluding the terminating NULs), can be allocated with 
+    // simple pointer increases, without allocating new chunks.
+    // 
+    // If the current chunk is not large enough, a single new chunk of the right size
+    // is allocated (the unused tail of the current chunk is wasted).
+    // On POSIX systems, this chunk is memory-mapped, so ShrinkToFit can return
+    // its unused pages.
+    // Throws std::bad_alloc on allocation failure
+    // (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    void Reserve(size_t totalChars, size_t expectedStrings)
+    {
+        const AllocError error = TryReserve(totalChars, expectedStrings);
+        if (error != AllocError::None)
+        {
+            RaiseAllocError(error);
+        }
+    }
+
+    // Non-throwing version of Reserve: returns the reason of the allocation failure
+    // (AllocError::None on success), leaving the allocator unchanged on failure.
+    AllocError TryReserve(size_t totalChars, size_t expectedStrings)
+    {
+        // Room for the terminating NULs (and the alignment padding, if any)
+        const size_t slotLength = m_alignmentMask + 1;
+        if (expectedStrings > (static_cast<size_t>(-1) - totalChars) / slotLength)
+        {
+            return AllocError::OutOfMemory;
+        }
+        const size_t length = totalChars + (expectedStrings * slotLength);
+
+        if (static_cast<size_t>(m_pLimit - m_pNext) >= length)
+        {
+            return AllocError::None;
+        }
+
+        return AddChunk(length, true);
+    }
+
+    // Return the unused tail of the current chunk to the memory allocator,
+    // e.g. after a Reserve call with overestimated sizes.
+    // Subsequent allocations will go into new chunks.
+    // Returns the number of released bytes (0 if the chunk can't be shrunk in place:
+    // with MSVC the chunk is shrunk with _expand, while on POSIX systems only 
+    // the chunks allocated by Reserve can be shrunk, by whole pages).
+    size_t ShrinkToFit() noexcept
+    {
+        if (m_chunks.empty() || m_pNext == m_pLimit)
+        {
+            return 0;
+        }
+
+        ChunkHeader* pChunk = m_chunks.back();
+        uint8_t* pChunkStart = reinterpret_cast<uint8_t*>(pChunk);
+        const size_t usedBytes = reinterpret_cast<uint8_t*>(m_pNext) - pChunkStart;
+
+        if (m_pNext == ChunkData(pChunk))
+        {
+            // No strings in the current chunk: release it entirely
+            const size_t releasedBytes = pChunk->SizeInBytes;
+            m_chunks.pop_back();
+            FreeChunk(pChunk);
+
+            m_allocatedBytes -= releasedBytes;
+            m_pNext = nullptr;
+            m_pLimit = nullptr;
+            return releasedBytes;
+        }
+
+        // Keep the tail padding
+        const size_t requestedSizeInBytes = usedBytes + m_tailPaddingInBytes;
+        if (requestedSizeInBytes >= pChunk->SizeInBytes)
+        {
+            return 0;
+        }
+
+        const size_t newSizeInBytes = ShrinkInPlace(pChunk, requestedSizeInBytes);
+        if (newSizeInBytes >= pChunk->SizeInBytes)
+        {
+            return 0;
+        }
+
+        const size_t releasedBytes = pChunk->SizeInBytes - newSizeInBytes;
+        pChunk->SizeInBytes = newSizeInBytes;
+
+        m_allocatedBytes -= releasedBytes;
+        m_pLimit = m_pNext;
+        return releasedBytes;
+    }
+
+    // Allocate a string using the pool allocator, deep-copying the string
+    // from a C-style NUL-terminated string pointer.
+    // Throws std::bad_alloc on allocation failure 
+    // (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    String AllocString(const CharT* ptr)
+    {
+        return AllocString(ptr, ptr + std::char_traits<CharT>::length(ptr));
+    }
+
+    // Allocate a string using the pool allocator, deep-copying the string
+    // from a [start, finish) "string view".
+    // As per the STL convention: start is included, finish is excluded.
+    // Throws std::bad_alloc on allocation failure
+    // (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    String AllocString(const CharT* start, const CharT* finish)
+    {
+        const size_t length = finish - start;
+        CharT* ptr = AllocMemory(AllocLength(length));
+        return MakeString(ptr, start, length);
+    }
+
+#ifdef STRINGPOOL_HAS_STRING_VIEW
+    // Allocate a string using the pool allocator, deep-copying the characters
+    // of a std::basic_string_view (or of anything convertible to it, 
+    // like std::basic_string).
+    // Throws std::bad_alloc on allocation failure
+    // (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    String AllocString(std::basic_string_view<CharT> str)
+    {
+        return AllocString(str.data(), str.data() + str.size());
+    }
+#endif
+
+    // Allocate 'count' strings in a single pass, deep-copying them from an array 
+    // of C-style NUL-terminated string pointers. 
+    // The allocated strings are appended to 'result'.
+    // Throws std::bad_alloc on allocation failure
+    // (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    void AllocStrings(const CharT* const* strings, size_t count, 
+                      std::vector<String>& result)
+    {
+        AllocStringsImpl(strings, count, result);
+    }
+
+    // Allocate 'count' strings in a single pass, deep-copying them from 
+    // an array of std::basic_strings (e.g. std::wstrings for StringPool::Allocator).
+    // The allocated strings are appended to 'result'.
+    // Throws std::bad_alloc on allocation failure
+    // (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    void AllocStrings(const std::basic_string<CharT>* strings, size_t count,
+                      std::vector<String>& result)
+    {
+        AllocStringsImpl(strings, count, result);
+    }
+
+#ifdef STRINGPOOL_HAS_STRING_VIEW
+    // Allocate 'count' strings in a single pass, deep-copying them from 
+    // an array of std::basic_string_views (e.g. views into a larger text buffer,
+    // that are not NUL-terminated).
+    // The allocated strings are appended to 'result'.
+    // Throws std::bad_alloc on allocation failure
+    // (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    void AllocStrings(const std::basic_string_view<CharT>* strings, size_t count,
+                      std::vector<String>& result)
+    {
+        AllocStringsImpl(strings, count, result);
+    }
+#endif
+
+    // Non-throwing version of AllocString: allocation failures are reported
+    // in the returned AllocResult instead of throwing.
+    AllocResult TryAllocString(const CharT* ptr)
+    {
+        return TryAllocString(ptr, ptr + std::char_traits<CharT>::length(ptr));
+    }
+
+    // Non-throwing version of AllocString: allocation failures are reported
+    // in the returned AllocResult instead of throwing.
+    AllocResult TryAllocString(const CharT* start, const CharT* finish)
+    {
+        const size_t length = finish - start;
+        AllocError error = AllocError::None;
+        CharT* ptr = TryAllocMemory(AllocLength(length), error);
+        if (ptr == nullptr)
+        {
+            return AllocResult{ error };
+        }
+
+        return AllocResult{ MakeString(ptr, start, length) };
+    }
+
+#ifdef STRINGPOOL_HAS_STRING_VIEW
+    // Non-throwing version of AllocString: allocation failures are reported
+    // in the returned AllocResult instead of throwing.
+    AllocResult TryAllocString(std::basic_string_view<CharT> str)
+    {
+        return TryAllocString(str.data(), str.data() + str.size());
+    }
+#endif
+
+    //
+    // Case-folded allocation.
+    //
+    // The source string is copied and case-folded (Unicode simple case folding,
+    // see StringPoolCaseFold.h) in a single pass into the pool memory, e.g. to store 
+    // the keys of case-insensitive symbol tables, that can then be compared and hashed
+    // with the plain (faster) String functions.
+    //
+
+    // Allocate the case-folded copy of a C-style NUL-terminated string.
+    // Throws std::bad_alloc on allocation failure
+    // (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    String AllocStringFolded(const CharT* ptr)
+    {
+        return AllocStringFolded(ptr, ptr + std::char_traits<CharT>::length(ptr));
+    }
+
+    // Allocate the case-folded copy of the [start, finish) string.
+    // Throws std::bad_alloc on allocation failure
+    // (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    String AllocStringFolded(const CharT* start, const CharT* finish)
+    {
+        const size_t length = finish - start;
+        const size_t maxLength = Detail::MaxFoldedLength<CharT>(length);
+        if (IsLongFolding(length, maxLength))
+        {
+            const AllocResult result = AllocLongFolded(start, length, maxLength);
+            if (!result)
+            {
+                RaiseAllocError(result.Error());
+            }
+            return result.Value();
+        }
+
+        CharT* ptr = AllocMemory(AllocLength(maxLength));
+        return MakeFoldedString(ptr, start, length);
+    }
+
+#ifdef STRINGPOOL_HAS_STRING_VIEW
+    // Allocate the case-folded copy of a string view.
+    String AllocStringFolded(std::basic_string_view<CharT> str)
+    {
+        return AllocStringFolded(str.data(), str.data() + str.size());
+    }
+#endif
+
+    // Non-throwing version of AllocStringFolded: allocation failures are reported
+    // in the returned AllocResult instead of throwing.
+    AllocResult TryAllocStringFolded(const CharT* start, const CharT* finish)
+    {
+        const size_t length = finish - start;
+        const size_t maxLength = Detail::MaxFoldedLength<CharT>(length);
+        if (IsLongFolding(length, maxLength))
+        {
+            return AllocLongFolded(start, length, maxLength);
+        }
+
+        AllocError error = AllocError::None;
+        CharT* ptr = TryAllocMemory(AllocLength(maxLength), error);
+        if (ptr == nullptr)
+        {
+            return AllocResult{ error };
+        }
+
+        return AllocResult{ MakeFoldedString(ptr, start, length) };
+    }
+
+    //
+    // Allocation from UTF-8 sources.
+    //
+    // The UTF-8 is transcoded to UTF-16 for 2-byte characters (char16_t, and wchar_t
+    // on Windows), and to UTF-32 for 4-byte characters (char32_t, and wchar_t on Linux
+    // and macOS); for 1-byte characters, it's validated and copied as it is.
+    // 
+    // The characters are written directly into the pool memory, with no intermediate
+    // std::wstring: room for one character per UTF-8 byte (an upper bound) is carved
+    // from the current chunk, and its unused tail is given back right after.
+    //
+
+    // Allocate a string transcoding the UTF-8 [start, finish) into the pool.
+    // Throws StringPool::InvalidUtf8 if the source is not valid UTF-8, 
+    // and std::bad_alloc on allocation failure 
+    // (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    String AllocStringFromUtf8(const char* start, const char* finish)
+    {
+        CharT* ptr = AllocMemory(AllocLength(finish - start));
+
+        String result;
+        const AllocError error = TranscodeUtf8(ptr, start, finish, result);
+        if (error != AllocError::None)
+        {
+            RaiseAllocError(error);
+        }
+        return result;
+    }
+
+    // Allocate a string transcoding a NUL-terminated UTF-8 string into the pool.
+    String AllocStringFromUtf8(const char* utf8)
+    {
+        return AllocStringFromUtf8(utf8, utf8 + strlen(utf8));
+    }
+
+    String AllocStringFromUtf8(const std::string& utf8)
+    {
+        return AllocStringFromUtf8(utf8.data(), utf8.data() + utf8.size());
+    }
+
+#ifdef STRINGPOOL_HAS_STRING_VIEW
+    String AllocStringFromUtf8(std::string_view utf8)
+    {
+        return AllocStringFromUtf8(utf8.data(), utf8.data() + utf8.size());
+    }
+#endif
+
+    // Non-throwing version of AllocStringFromUtf8: allocation failures and invalid
+    // sources are reported in the returned AllocResult instead of throwing.
+    AllocResult TryAllocStringFromUtf8(const char* start, const char* finish)
+    {
+        AllocError error = AllocError::None;
+        CharT* ptr = TryAllocMemory(AllocLength(finish - start), error);
+        if (ptr == nullptr)
+        {
+            return AllocResult{ error };
+        }
+
+        String result;
+        error = TranscodeUtf8(ptr, start, finish, result);
+        if (error != AllocError::None)
+        {
+            return AllocResult{ error };
+        }
+        return AllocResult{ result };
+    }
+
+    //
+    // Tokenization.
+    //
+    // Room for the whole source block is allocated in the pool once, and the block
+    // is copied with a SIMD scan finding the delimiters in the same pass: each 
+    // delimiter is replaced with a NUL, so the tokens are NUL-terminated pool strings
+    // pointing into the block copy (one allocation per block, instead of one 
+    // allocation, scan and memcpy per token).
+    // Unlike the other strings, the tokens don't follow the alignment set by 
+    // SetStringAlignment.
+    //
+
+    // Split the [start, finish) block on 'delimiter', appending the tokens to 'tokens':
+    // n delimiters give n + 1 tokens (including the empty ones).
+    // The block can be longer than the maximum string length.
+    // Throws std::bad_alloc on allocation failure
+    // (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    void AllocTokens(const CharT* start, const CharT* finish, CharT delimiter,
+                     std::vector<String>& tokens)
+    {
+        const size_t length = finish - start;
+        CharT* block = AllocBlock(length);
+        SplitBlock(block, start, length, delimiter, false, tokens);
+    }
+
+#ifdef STRINGPOOL_HAS_STRING_VIEW
+    void AllocTokens(std::basic_string_view<CharT> str, CharT delimiter, 
+                     std::vector<String>& tokens)
+    {
+        AllocTokens(str.data(), str.data() + str.size(), delimiter, tokens);
+    }
+#endif
+
+    // Split the [start, finish) text block into lines, appending them to 'lines'.
+    // Lines end with "\n" or "\r\n" (not included in the strings), and the text after
+    // the last line break (if any) is the last line: e.g. "a\r\nb\n" and "a\nb" both 
+    // give "a" and "b", and an empty block gives no lines.
+    // Throws std::bad_alloc on allocation failure
+    // (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    void AllocLines(const CharT* start, const CharT* finish, std::vector<String>& lines)
+    {
+        if (start != finish && finish[-1] == CharT('\n'))
+        {
+            --finish;
+        }
+        else if (start == finish)
+        {
+            return;
+        }
+
+        const size_t length = finish - start;
+        CharT* block = AllocBlock(length);
+        SplitBlock(block, start, length, CharT('\n'), true, lines);
+    }
+
+    //
+    // Raw memory allocation, to reuse the pool chunks for other data
+    // (see StlAllocator, and StringPoolPmr.h).
+    //
+
+    // Allocate 'sizeInBytes' bytes of raw memory from the pool chunks, aligned 
+    // to 'alignment' (a power of two), with the same pointer-increase fast path
+    // of the strings.
+    // Like the strings, the memory is released only by Clear, or by the allocator 
+    // destructor.
+    // Throws std::bad_alloc on allocation failure
+    // (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    void* AllocBytes(size_t sizeInBytes, size_t alignment = alignof(std::max_align_t))
+    {
+        // Room for the block and its alignment padding can't be computed
+        if (sizeInBytes > static_cast<size_t>(-1) - alignment - sizeof(CharT))
+        {
+            RaiseAllocError(AllocError::OutOfMemory);
+        }
+
+        void* ptr = CarveBytes(sizeInBytes, alignment);
+        if (ptr != nullptr)
+        {
+            return ptr;
+        }
+
+        // Allocate a new chunk, with room for the block and its alignment padding.
+        // Unlike strings, there's no limit on the block size (except the memory budget).
+        const size_t length = (sizeInBytes + alignment - 1 + sizeof(CharT) - 1) 
+            / sizeof(CharT);
+        const AllocError error = AddChunk(length);
+        if (error != AllocError::None)
+        {
+            RaiseAllocError(error);
+        }
+
+        return CarveBytes(sizeInBytes, alignment);
+    }
+
+
+private:
+
+    // A memory chunk is made by this header followed by the allocated characters.
+    struct ChunkHeader 
+    {
+        // Total chunk size, in bytes
+        size_t SizeInBytes;
+
+        // Allocated with mmap instead of malloc (see Reserve)
+        bool IsMapped;
+
+        // Followed by array of characters 
+        CharT Chars[1];
+    };
+
+    enum 
+    {
+        // An allocated chunk must be minimum this size, in bytes
+        kMinChunkSizeInBytes = 600000,
+
+        // Can't alloc strings larger than that (in characters)
+        kMaxStringLength = 1024 * 1024,
+
+        // Number of strings processed together by AllocStrings
+        kBatchBlockSize = 256
+    };
+
+
+    CharT*  m_pNext{};      // First available character slot in the current chunk
+    CharT*  m_pLimit{};     // One past last available character slot in the current chunk
+
+    // Keep a list of all allocated chunks.
+    // NOTE: ChunkHeader pointers are *owning* raw pointers, 
+    // that will be released by this class destructor.
+    std::vector<ChunkHeader*> m_chunks{};
+
+    // Memory budget (0 means no limit)
+    size_t m_allocatedBytes{};      // Total size of the allocated chunks, in bytes
+    size_t m_softLimitInBytes{};
+    size_t m_hardLimitInBytes{};
+    bool m_softLimitNotified{};
+    SoftLimitCallback m_softLimitCallback{};
+
+    // Chunk layout for SIMD kernels (see SetTailPadding and SetStringAlignment)
+    size_t m_tailPaddingInBytes{};  // Readable bytes after m_pLimit in each chunk
+    size_t m_alignmentMask{};       // String alignment in characters, minus one
+
+
+    //------------------------------------------------------------------------------------
+    // Helper Methods
+    //------------------------------------------------------------------------------------
+
+
+    //
+    // Helper functions to allocate and free memory.
+    // Those could be factored out as a trait class, to experiment with pool allocators
+    // using different alloc/free techniques/APIs.
+    // 
+
+    // Request a memory allocation.
+    // Return nullptr on failure.
+    static void* Allocate(size_t cbSize) noexcept
+    {
+        return malloc(cbSize);
+    }
+
+    // Free a previous allocation.
+    static void Free(void* ptr) noexcept
+    {
+        return free(ptr);
+    }
+
+    // Allocate a chunk of 'cbSize' bytes, memory-mapping it if 'mapped' is true
+    // (and memory-mapped chunks are available on this platform).
+    // Return nullptr on failure.
+    static ChunkHeader* AllocateChunk(size_t cbSize, bool mapped) noexcept
+    {
+        void* ptr = nullptr;
+#if defined(STRINGPOOL_HAS_MAPPED_CHUNKS)
+        if (mapped)
+        {
+            ptr = mmap(nullptr, cbSize, PROT_READ | PROT_WRITE, 
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (ptr == MAP_FAILED)
+            {
+                return nullptr;
+            }
+        }
+        else
+#endif
+        {
+            mapped = false;
+            ptr = Allocate(cbSize);
+            if (ptr == nullptr)
+            {
+                return nullptr;
+            }
+        }
+
+        ChunkHeader* pChunk = static_cast<ChunkHeader*>(ptr);
+        pChunk->SizeInBytes = cbSize;
+        pChunk->IsMapped = mapped;
+        return pChunk;
+    }
+
+    // Free a chunk allocated by AllocateChunk.
+    static void FreeChunk(ChunkHeader* pChunk) noexcept
+    {
+#if defined(STRINGPOOL_HAS_MAPPED_CHUNKS)
+        if (pChunk->IsMapped)
+        {
+            munmap(pChunk, pChunk->SizeInBytes);
+            return;
+        }
+#endif
+        Free(pChunk);
+    }
+
+    // Try to shrink a chunk *in place* (the memory block must not move,
+    // as pool strings point inside it), to no less than 'cbNewSize' bytes.
+    // Return the new chunk size (unchanged if the chunk can't be shrunk in place).
+    static size_t ShrinkInPlace(ChunkHeader* pChunk, size_t cbNewSize) noexcept
+    {
+#if defined(_MSC_VER)
+        if (_expand(pChunk, cbNewSize) != nullptr)
+        {
+            return cbNewSize;
+        }
+#elif defined(STRINGPOOL_HAS_MAPPED_CHUNKS)
+        // Unmap the whole pages after the new end 
+        // (the C runtime offers no portable in-place shrink: realloc may move the block)
+        if (pChunk->IsMapped)
+        {
+            const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            const size_t cbMapped = (cbNewSize + pageSize - 1) & ~(pageSize - 1);
+            if (cbMapped < pChunk->SizeInBytes
+                && munmap(reinterpret_cast<uint8_t*>(pChunk) + cbMapped, 
+                          pChunk->SizeInBytes - cbMapped) == 0)
+            {
+                return cbMapped;
+            }
+        }
+#endif
+        return pChunk->SizeInBytes;
+    }
+
+    // Number of characters to allocate for a string of given length: 
+    // room for the terminating NUL, rounded up to keep the string starts aligned.
+    size_t AllocLength(size_t length) const noexcept
+    {
+        return (length + 1 + m_alignmentMask) & ~m_alignmentMask;
+    }
+
+    // First character available for strings in a chunk, after the header, 
+    // and aligned as requested by SetStringAlignment.
+    CharT* ChunkData(ChunkHeader* pChunk) const noexcept
+    {
+        const uintptr_t alignmentInBytes = (m_alignmentMask + 1) * sizeof(CharT);
+        const uintptr_t data = reinterpret_cast<uintptr_t>(pChunk + 1);
+        return reinterpret_cast<CharT*>(
+            (data + alignmentInBytes - 1) & ~(alignmentInBytes - 1));
+    }
+
+    // Copy length characters from source to the pool memory pointed by ptr,
+    // and NUL-terminate the copied string.
+    String MakeString(CharT* ptr, const CharT* source, size_t length)
+    {
+        // Note: empty views may have a null data pointer, that can't be passed
+        // to memcpy (not even for 0 bytes).
+        if (length != 0)
+        {
+            memcpy(ptr, source, length * sizeof(CharT));
+        }
+        ptr[length] = CharT(); // terminating NUL
+
+        Instrumentation::OnAllocString(length);
+
+        return String{ ptr, length };
+    }
+
+    // Allocate room for a block of 'length' characters and its terminating NUL, 
+    // with no limit on the length (except the memory budget).
+    // Throws std::bad_alloc on allocation failure.
+    CharT* AllocBlock(size_t length)
+    {
+        const size_t allocLength = AllocLength(length);
+        if (allocLength <= kMaxStringLength)
+        {
+            return AllocMemory(allocLength);
+        }
+
+        // Very long blocks get a chunk of their own
+        const AllocError error = AddChunk(allocLength);
+        if (error != AllocError::None)
+        {
+            RaiseAllocError(error);
+        }
+
+        CharT* ptr = m_pNext;
+        m_pNext += allocLength;
+        return ptr;
+    }
+
+    // Copy source[0, length) to block[0, length], replacing the delimiters with NULs
+    // (and NUL-terminating the block), and append the tokens to 'tokens'
+    // (dropping a carriage return at the end of each token, if requested).
+    // The delimiters are found while copying, in a single pass over the source.
+    void SplitBlock(CharT* block, const CharT* source, size_t length, CharT delimiter,
+                    bool trimCarriageReturns, std::vector<String>& tokens)
+    {
+        size_t tokenStart = 0;
+        for (;;)
+        {
+            size_t tokenLength = Detail::CopyUntilChar(block + tokenStart, 
+                source + tokenStart, length - tokenStart, delimiter);
+            CharT* token = block + tokenStart;
+            const size_t nextStart = tokenStart + tokenLength + 1;
+
+            if (trimCarriageReturns && tokenLength != 0 
+                && token[tokenLength - 1] == CharT('\r'))
+            {
+                --tokenLength;
+            }
+            token[tokenLength] = CharT();
+
+            Instrumentation::OnAllocString(tokenLength);
+            tokens.push_back(String{ token, tokenLength });
+
+            tokenStart = nextStart;
+            if (tokenStart > length)
+            {
+                break;
+            }
+        }
+    }
+
+    // Carve 'sizeInBytes' bytes aligned to 'alignment' from the current chunk, 
+    // with a simple pointer increase.
+    // Returns nullptr if there's not enough room in the current chunk.
+    void* CarveBytes(size_t sizeInBytes, size_t alignment) noexcept
+    {
+        if (m_pNext == nullptr)
+        {
+            return nullptr;
+        }
+
+        const uintptr_t limit = reinterpret_cast<uintptr_t>(m_pLimit);
+        const uintptr_t start = (reinterpret_cast<uintptr_t>(m_pNext) + alignment - 1) 
+            & ~static_cast<uintptr_t>(alignment - 1);
+        if (start > limit || limit - start < sizeInBytes)
+        {
+            return nullptr;
+        }
+
+        // Keep the next string aligned
+        const uintptr_t stringAlignment = (m_alignmentMask + 1) * sizeof(CharT);
+        const uintptr_t end = (start + sizeInBytes + stringAlignment - 1) 
+            & ~(stringAlignment - 1);
+        m_pNext = end < limit ? reinterpret_cast<CharT*>(end) : m_pLimit;
+
+        return reinterpret_cast<void*>(start);
+    }
+
+    // Copy length characters from source to the pool memory pointed by ptr, 
+    // case-folding them, and NUL-terminate the folded string.
+    // The memory at ptr has been allocated for MaxFoldedLength(length) characters:
+    // the unused tail (if any) is given back to the current chunk.
+    String MakeFoldedString(CharT* ptr, const CharT* source, size_t length) noexcept
+    {
+        const size_t foldedLength = Detail::FoldCase(source, length, ptr);
+
+        // This is the last allocation carved from the current chunk, 
+        // so it can be trimmed in place
+        m_pNext = ptr + AllocLength(foldedLength);
+        ptr[foldedLength] = CharT(); // terminating NUL
+
+        Instrumentation::OnAllocString(foldedLength);
+
+        return String{ ptr, foldedLength };
+    }
+
+    // True if the worst-case folded copy of a string of 'length' characters
+    // (of up to 'maxLength' characters, i.e. a UTF-8 string) may not fit a pool string,
+    // while its actual folded copy may.
+    bool IsLongFolding(size_t length, size_t maxLength) const noexcept
+    {
+        return maxLength != length && AllocLength(maxLength) > kMaxStringLength;
+    }
+
+    // Case-fold a long string into a temporary buffer, with room for 'maxLength'
+    // characters, and copy it to the pool: this way, only the actual folded length
+    // is checked against the maximum string length.
+    // Doesn't throw on allocation failure: returns the error code instead.
+    AllocResult AllocLongFolded(const CharT* source, size_t length, size_t maxLength)
+    {
+        CharT* folded = static_cast<CharT*>(malloc(maxLength * sizeof(CharT)));
+        if (folded == nullptr)
+        {
+            return AllocResult{ AllocError::OutOfMemory };
+        }
+
+        const size_t foldedLength = Detail::FoldCase(source, length, folded);
+
+        AllocError error = AllocError::None;
+        CharT* ptr = TryAllocMemory(AllocLength(foldedLength), error);
+        if (ptr == nullptr)
+        {
+            free(folded);
+            return AllocResult{ error };
+        }
+
+        const String str = MakeString(ptr, folded, foldedLength);
+        free(folded);
+        return AllocResult{ str };
+    }
+
+    // Transcode the UTF-8 [start, finish) into the pool memory pointed by ptr, 
+    // just allocated with room for one character per UTF-8 byte, and give 
+    // the unused tail back to the current chunk.
+    // If the source is not valid UTF-8, the whole allocation is given back.
+    AllocError TranscodeUtf8(CharT* ptr, const char* start, const char* finish, 
+                             String& result) noexcept
+    {
+        const size_t length = Detail::TranscodeFromUtf8(start, finish - start, ptr);
+        if (length == Detail::kInvalidUtf8)
+        {
+            m_pNext = ptr;
+            return AllocError::InvalidUtf8;
+        }
+
+        // This is the last allocation carved from the current chunk, 
+        // so it can be trimmed in place
+        m_pNext = ptr + AllocLength(length);
+        ptr[length] = CharT(); // terminating NUL
+
+        Instrumentation::OnAllocString(length);
+
+        result = String{ ptr, length };
+        return AllocError::None;
+    }
+
+    // Access the source strings of AllocStrings.
+    static const CharT* SourceChars(const CharT* str) noexcept
+    {
+        return str;
+    }
+
+    static const CharT* SourceChars(const std::basic_string<CharT>& str) noexcept
+    {
+        return str.c_str();
+    }
+
+    static size_t SourceLength(const CharT* str) noexcept
+    {
+        return std::char_traits<CharT>::length(str);
+    }
+
+    static size_t SourceLength(const std::basic_string<CharT>& str) noexcept
+    {
+        return str.size();
+    }
+
+#ifdef STRINGPOOL_HAS_STRING_VIEW
+    static const CharT* SourceChars(std::basic_string_view<CharT> str) noexcept
+    {
+        return str.data();
+    }
+
+    static size_t SourceLength(std::basic_string_view<CharT> str) noexcept
+    {
+        return str.size();
+    }
+#endif
+
+    // Implementation of the AllocStrings batch functions.
+    //
+    // The source strings are processed in blocks: the lengths of the strings
+    // in a block are computed once (while their characters are still hot in cache),
+    // room for the whole block is made with a single bounds check (allocating 
+    // a new chunk if needed), and then the strings are copied and NUL-terminated
+    // with simple pointer increases.
+    template <typename Source>
+    void AllocStringsImpl(const Source* strings, size_t count, 
+                          std::vector<String>& result)
+    {
+        result.reserve(result.size() + count);
+
+        size_t lengths[kBatchBlockSize];
+
+        for (size_t blockStart = 0; blockStart < count; blockStart += kBatchBlockSize)
+        {
+            const Source* block = strings + blockStart;
+            const size_t blockCount = (count - blockStart) < kBatchBlockSize ?
+                (count - blockStart) : static_cast<size_t>(kBatchBlockSize);
+
+            // Total characters in the block, including the terminating NULs
+            // (and the alignment padding, if any)
+            size_t blockTotal = 0;
+            for (size_t i = 0; i < blockCount; ++i)
+            {
+                lengths[i] = SourceLength(block[i]);
+                blockTotal += AllocLength(lengths[i]);
+            }
+
+            if (blockTotal > kMaxStringLength)
+            {
+                // Very long strings: allocate them one by one
+                for (size_t i = 0; i < blockCount; ++i)
+                {
+                    CharT* ptr = AllocMemory(AllocLength(lengths[i]));
+                    result.push_back(MakeString(ptr, SourceChars(block[i]), lengths[i]));
+                }
+                continue;
+            }
+
+            // Make room for the whole block
+            if (m_pNext + blockTotal > m_pLimit)
+            {
+                const AllocError error = AllocChunk(blockTotal);
+                if (error != AllocError::None)
+                {
+                    RaiseAllocError(error);
+                }
+            }
+
+            CharT* ptr = m_pNext;
+            m_pNext += blockTotal;
+
+            for (size_t i = 0; i < blockCount; ++i)
+            {
+                // Note: string views are not NUL-terminated, and empty ones may have
+                // a null data pointer, that can't be passed to memcpy
+                const size_t length = lengths[i];
+                if (length != 0)
+                {
+                    memcpy(ptr, SourceChars(block[i]), length * sizeof(CharT));
+                }
+                ptr[length] = CharT(); // terminating NUL
+
+                Instrumentation::OnAllocString(length);
+                result.push_back(String{ ptr, length });
+
+                ptr += AllocLength(length);
+            }
+        }
+    }
+
+    // Report an allocation failure to the throwing API.
+    // When building without exceptions, the process is aborted.
+    [[noreturn]] static void RaiseAllocError(AllocError error)
+    {
+#ifdef STRINGPOOL_NO_EXCEPTIONS
+        (void)error;
+        std::abort();
+#else
+        if (error == AllocError::BudgetExceeded)
+        {
+            throw BudgetExceeded();
+        }
+
+        if (error == AllocError::InvalidUtf8)
+        {
+            throw InvalidUtf8();
+        }
+
+        if (error == AllocError::StringTooLong)
+        {
+            throw std::bad_alloc();
+        }
+
+        // Allocation failure: throw std::bad_alloc
+        static std::bad_alloc outOfMemory;
+        throw outOfMemory;
+#endif
+    }
+
+    // Helper function to allocate memory using the pool allocator.
+    // 'length' is the number of characters requested.
+    // 
+    // First tries to carve memory from the current chunk.
+    // If there's not enough space, allocates a new chunk.
+    // Throws std::bad_alloc on allocation errors.
+    CharT* AllocMemory(size_t length)
+    {      
+        // First let's try allocation in current chunk
+        CharT* ptr = m_pNext;
+        if (m_pNext + length <= m_pLimit)
+        {
+            // There's enough room in current chunk, so a simple pointer increase will do!
+            m_pNext += length;
+            return ptr;
+        }
+
+        // There's not enough room in current chunk. We need to allocate a new chunk.
+        const AllocError error = AllocChunk(length);
+        if (error != AllocError::None)
+        {
+            RaiseAllocError(error);
+        }
+
+        // Now that we have allocated a new chunk, 
+        // we can retry the allocation with a simple pointer increase
+        return AllocMemory(length);
+    }
+
+    // Same as AllocMemory, but reports allocation errors returning nullptr,
+    // and storing the reason in 'error'.
+    CharT* TryAllocMemory(size_t length, AllocError& error)
+    {
+        // First let's try allocation in current chunk
+        CharT* ptr = m_pNext;
+        if (m_pNext + length <= m_pLimit)
+        {
+            // There's enough room in current chunk, so a simple pointer increase will do!
+            m_pNext += length;
+            return ptr;
+        }
+
+        // There's not enough room in current chunk. We need to allocate a new chunk.
+        error = AllocChunk(length);
+        if (error != AllocError::None)
+        {
+            return nullptr;
+        }
+
+        return TryAllocMemory(length, error);
+    }
+
+    // Allocation slow path: allocate a new chunk, large enough to serve 
+    // a request of 'length' characters, and make it the current chunk.
+    // Doesn't throw on allocation failure: returns the error code instead.
+    AllocError AllocChunk(size_t length)
+    {
+        // Prevent request of too long strings
+        if (length > kMaxStringLength)
+        {
+            return AllocError::StringTooLong;
+        }
+
+        return AddChunk(length);
+    }
+
+    // Allocate a new chunk, with room for at least 'length' characters,
+    // and make it the current chunk.
+    // Unlike AllocChunk, there's no limit on 'length' (except the memory budget).
+    // If 'mapped' is true, the chunk is memory-mapped where available, so that
+    // ShrinkToFit can release its unused pages.
+    // Doesn't throw on allocation failure: returns the error code instead.
+    AllocError AddChunk(size_t length, bool mapped = false)
+    {
+        // Allocate a new chunk, not smaller than minimum chunk size.
+        // Besides the header, leave room to align the first string, 
+        // and for the tail padding.
+        const size_t overheadBytes = sizeof(ChunkHeader) 
+            + (m_alignmentMask * sizeof(CharT)) + m_tailPaddingInBytes;
+        if (length > (static_cast<size_t>(-1) - overheadBytes) / sizeof(CharT))
+        {
+            return AllocError::OutOfMemory;
+        }
+
+        const size_t requiredBytes = (length * sizeof(CharT)) + overheadBytes;
+        size_t chunkSizeInBytes = requiredBytes;
+        if (chunkSizeInBytes < kMinChunkSizeInBytes)
+        {
+            chunkSizeInBytes = kMinChunkSizeInBytes;
+        }
+
+        // Respect the hard memory limit, if any
+        if (m_hardLimitInBytes != 0)
+        {
+            size_t availableBytes = m_hardLimitInBytes > m_allocatedBytes ?
+                m_hardLimitInBytes - m_allocatedBytes : 0;
+
+            // Keep the chunk end aligned on a character boundary
+            availableBytes -= availableBytes % sizeof(CharT);
+
+            if (requiredBytes > availableBytes)
+            {
+                return AllocError::BudgetExceeded;
+            }
+
+            // Shrink the new chunk to fit the remaining budget
+            if (chunkSizeInBytes > availableBytes)
+            {
+                chunkSizeInBytes = availableBytes;
+            }
+        }
+
+        Instrumentation::OnChunkAllocStart();
+
+        ChunkHeader* pNewChunk = AllocateChunk(chunkSizeInBytes, mapped);
+        if (pNewChunk == nullptr)
+        {
+            return AllocError::OutOfMemory;
+        }
+        uint8_t* pChunkStart = reinterpret_cast<uint8_t*>(pNewChunk);
+
+        // Zero the alignment and tail padding bytes (see SetTailPadding)
+        if ((m_alignmentMask != 0 || m_tailPaddingInBytes != 0) && !pNewChunk->IsMapped)
+        {
+            memset(pChunkStart + sizeof(ChunkHeader), 0, 
+                   chunkSizeInBytes - sizeof(ChunkHeader));
+        }
+
+        // Keep track of the newly allocated chunk,
+        // adding it to the chunk pointer vector
+#ifdef STRINGPOOL_NO_EXCEPTIONS
+        m_chunks.push_back(pNewChunk);
+#else
+        try
+        {
+            m_chunks.push_back(pNewChunk);
+        }
+        catch (const std::bad_alloc&)
+        {
+            FreeChunk(pNewChunk);
+            return AllocError::OutOfMemory;
+        }
+#endif
+        m_allocatedBytes += chunkSizeInBytes;
+
+        // Point one past the last available character in current chunk,
+        // leaving the tail padding after it
+        m_pLimit = reinterpret_cast<CharT*>(
+            pChunkStart + chunkSizeInBytes - m_tailPaddingInBytes);
+        
+        // Set the pointer to point to the free bytes to serve the next allocation
+        m_pNext = ChunkData(pNewChunk);
+
+        Instrumentation::OnChunkAllocFinish(chunkSizeInBytes);
+
+        NotifySoftLimit();
+
+        return AllocError::None;
+    }
+
+    // Notify the crossing of the soft memory limit, if any.
+    void NotifySoftLimit()
+    {
+        if (m_softLimitInBytes != 0 && !m_softLimitNotified
+            && m_allocatedBytes > m_softLimitInBytes)
+        {
+            m_softLimitNotified = true;
+            if (m_softLimitCallback)
+            {
+                m_softLimitCallback(m_allocatedBytes, m_softLimitInBytes);
+            }
+        }
+    }
+};
+
+
+//========================================================================================
+//                          STL Allocator
+//========================================================================================
+
+//----------------------------------------------------------------------------------------
+// Allocator for the standard containers (e.g. std::vector, std::map), drawing memory
+// from the chunks of a string pool allocator (see BasicAllocator::AllocBytes).
+// 
+// This way, a whole index of pooled strings (the strings, and the container elements 
+// or nodes) lives in the same arena: deallocate is a no-op, and all the memory is 
+// released together by the pool allocator (Clear, or destructor), in O(chunks) 
+// instead of one free per node.
+//
+// The pool allocator must outlive the containers using it.
+// Copies (and rebound copies) of an StlAllocator share the same pool allocator,
+// and compare equal.
+//----------------------------------------------------------------------------------------
+template <typename T, typename AllocatorType = Allocator>
+class StlAllocator
+{
+public:
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef StlAllocator<U, AllocatorType> other;
+    };
+
+    // The container memory is owned by the pool allocator: move it along with 
+    // the container contents
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    explicit StlAllocator(AllocatorType& allocator) noexcept
+        : m_allocator{ &allocator }
+    {}
+
+    // Rebound copy
+    template <typename U>
+    StlAllocator(const StlAllocator<U, AllocatorType>& other) noexcept
+        : m_allocator{ &other.GetAllocator() }
+    {}
+
+    // The string pool allocator owning the memory.
+    AllocatorType& GetAllocator() const noexcept
+    {
+        return *m_allocator;
+    }
+
+    // Allocate room for 'count' objects of type T.
+    // Throws std::bad_alloc on allocation failure
+    // (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    T* allocate(size_t count)
+    {
+        if (count > static_cast<size_t>(-1) / sizeof(T))
+        {
+#ifdef STRINGPOOL_NO_EXCEPTIONS
+            std::abort();
+#else
+            throw std::bad_alloc();
+#endif
+        }
+
+        return static_cast<T*>(m_allocator->AllocBytes(count * sizeof(T), alignof(T)));
+    }
+
+    // The memory is released with the pool chunks.
+    void deallocate(T* /* ptr */, size_t /* count */) noexcept
+    {}
+
+
+private:
+    AllocatorType* m_allocator;
+};
+
+template <typename T, typename U, typename AllocatorType>
+inline bool operator==(const StlAllocator<T, AllocatorType>& a, 
+                       const StlAllocator<U, AllocatorType>& b) noexcept
+{
+    return &a.GetAllocator() == &b.GetAllocator();
+}
+
+template <typename T, typename U, typename AllocatorType>
+inline bool operator!=(const StlAllocator<T, AllocatorType>& a, 
+                       const StlAllocator<U, AllocatorType>& b) noexcept
+{
+    return !(a == b);
+}
+
+
+} // namespace StringPool
+
+
+#endif // INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_H
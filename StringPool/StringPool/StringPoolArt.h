@@ -0,0 +1,839 @@
+#ifndef INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_ART_H
+#define INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_ART_H
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//
+// Adaptive radix tree (ART) index over pooled strings (StringPool::ArtIndex),
+// for point lookups, prefix scans and range scans on large sets of keys.
+//
+// The tree branches on the key bytes (the big-endian bytes of the characters),
+// with inner nodes of 4, 16, 48 and 256 children that grow as needed, and compressed
+// paths for the chains of single-child nodes.
+// The leaves refer to the pool-allocated key strings (that are not copied), and both
+// the nodes and the leaves are allocated from the chunks of the string pool allocator,
+// so the whole index is released together with the pool.
+//
+// Copyright (C) by Giovanni Dicanio
+//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "StringPool.h"
+
+#include <cstddef>      // For size_t
+#include <cstdint>      // For uint8_t, uintptr_t
+#include <cstring>      // For memmove
+#include <new>          // For placement new
+#include <type_traits>  // For std::make_unsigned, std::is_trivially_destructible
+
+
+namespace StringPool
+{
+
+namespace Detail
+{
+
+// Byte i of a key, made by the big-endian bytes of its characters (taken as unsigned),
+// so that the byte order matches the character order.
+template <typename CharT>
+inline uint8_t ArtKeyByte(const CharT* key, size_t i) noexcept
+{
+    typedef typename std::make_unsigned<CharT>::type UnsignedChar;
+
+    const UnsignedChar ch = static_cast<UnsignedChar>(key[i / sizeof(CharT)]);
+    const size_t shift = 8 * (sizeof(CharT) - 1 - (i % sizeof(CharT)));
+    return static_cast<uint8_t>(ch >> shift);
+}
+
+// Index of the first mismatching key byte of a and b in [first, last),
+// or last if they're equal (both keys must have at least 'last' bytes).
+template <typename CharT>
+inline size_t ArtMismatch(const CharT* a, const CharT* b, size_t first, size_t last) noexcept
+{
+    size_t i = first;
+
+    // Compare the whole characters with the SIMD kernels, and the partial ones by byte
+    while (i < last && (i % sizeof(CharT)) != 0)
+    {
+        if (ArtKeyByte(a, i) != ArtKeyByte(b, i))
+        {
+            return i;
+        }
+        ++i;
+    }
+
+    const size_t charCount = (last - i) / sizeof(CharT);
+    if (charCount != 0)
+    {
+        const size_t index = i / sizeof(CharT);
+        const size_t mismatch = Mismatch(a + index, b + index, charCount);
+        i += mismatch * sizeof(CharT);
+        if (mismatch < charCount)
+        {
+            last = i + sizeof(CharT);
+        }
+    }
+
+    while (i < last && ArtKeyByte(a, i) == ArtKeyByte(b, i))
+    {
+        ++i;
+    }
+    return i;
+}
+
+// Compare keys by their unsigned character values, like the key bytes.
+template <typename CharT>
+inline int ArtCompareKeys(const CharT* a, size_t aLength,
+                          const CharT* b, size_t bLength) noexcept
+{
+    typedef typename std::make_unsigned<CharT>::type UnsignedChar;
+
+    const size_t minLength = (aLength < bLength) ? aLength : bLength;
+    const size_t i = (minLength != 0) ? Mismatch(a, b, minLength) : 0;
+    if (i < minLength)
+    {
+        return (static_cast<UnsignedChar>(a[i]) < static_cast<UnsignedChar>(b[i])) ? -1 : 1;
+    }
+    return (aLength < bLength) ? -1 : (aLength > bLength) ? 1 : 0;
+}
+
+} // namespace Detail
+
+
+//----------------------------------------------------------------------------------------
+// Adaptive radix tree mapping pooled strings to values.
+//
+// The key strings and the pool allocator must outlive the index.
+// Keys are ordered by their unsigned character values (for wchar_t keys, this is
+// the same order as String comparisons for any valid text).
+//
+// Nodes are never freed until the pool releases its chunks, so the values must be
+// trivially destructible (e.g. integers, indexes, pointers), and keys can't be removed.
+// Like the allocator, this class is not thread-safe; concurrent lookups are fine.
+//
+// StringPool::ArtIndex<ValueT> indexes wchar_t strings.
+//----------------------------------------------------------------------------------------
+template <typename CharT, typename ValueT, typename AllocatorType = BasicAllocator<CharT>>
+class BasicArtIndex
+{
+    static_assert(std::is_trivially_destructible<ValueT>::value,
+                  "ArtIndex values are released with the pool chunks, without destruction.");
+
+public:
+    typedef BasicString<CharT> String;
+
+    // Creates an empty index, allocating its nodes from the input pool allocator.
+    explicit BasicArtIndex(AllocatorType& allocator) noexcept
+        : m_allocator{ &allocator }
+    {}
+
+    // Ban copy: the nodes are shared with the pool
+    BasicArtIndex(const BasicArtIndex&) = delete;
+    BasicArtIndex& operator=(const BasicArtIndex&) = delete;
+
+    // Number of keys in the index.
+    size_t Size() const noexcept
+    {
+        return m_size;
+    }
+
+    bool IsEmpty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    // Add a pool-allocated key with its value.
+    // Returns false if the key is already in the index (its value isn't changed).
+    // Throws std::bad_alloc on allocation failure
+    // (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    bool Insert(const String& key, const ValueT& value)
+    {
+        const CharT* chars = key.Str();
+        const size_t keyBytes = key.Length() * sizeof(CharT);
+
+        void** ref = &m_root;
+        size_t depth = 0;
+        for (;;)
+        {
+            void* child = *ref;
+            if (child == nullptr)
+            {
+                *ref = TagLeaf(NewLeaf(key, value));
+                ++m_size;
+                return true;
+            }
+
+            if (IsLeaf(child))
+            {
+                // Replace the leaf with a node holding both keys,
+                // with their common bytes as compressed path
+                Leaf* leaf = AsLeaf(child);
+                const CharT* otherChars = leaf->Key.Str();
+                const size_t otherBytes = leaf->Key.Length() * sizeof(CharT);
+
+                const size_t limit = (keyBytes < otherBytes) ? keyBytes : otherBytes;
+                const size_t common = Detail::ArtMismatch(chars, otherChars, depth, limit);
+
+                if (common == keyBytes && common == otherBytes)
+                {
+                    return false;
+                }
+
+                Node* node = NewNode<Node4>(kNode4);
+                SetPrefix(node, chars, depth, common - depth);
+                *ref = node;
+                AttachLeaf(ref, node, common, leaf);
+                AttachLeaf(ref, node, common, NewLeaf(key, value));
+                ++m_size;
+                return true;
+            }
+
+            Node* node = AsNode(child);
+            if (node->PrefixLength != 0)
+            {
+                const size_t limit = (depth + node->PrefixLength < keyBytes) ?
+                    depth + node->PrefixLength : keyBytes;
+                const size_t i = Detail::ArtMismatch(node->PrefixKey, chars, depth, limit) - depth;
+
+                if (i < node->PrefixLength)
+                {
+                    // Split the compressed path where the key diverges
+                    Node* parent = NewNode<Node4>(kNode4);
+                    SetPrefix(parent, node->PrefixKey, node->PrefixStart, i);
+                    const uint8_t nodeByte = PrefixByte(node, i);
+                    node->PrefixStart += i + 1;
+                    node->PrefixLength -= static_cast<uint32_t>(i + 1);
+
+                    *ref = parent;
+                    AddChild(ref, parent, nodeByte, node);
+                    AttachLeaf(ref, parent, depth + i, NewLeaf(key, value));
+                    ++m_size;
+                    return true;
+                }
+
+                depth += node->PrefixLength;
+            }
+
+            if (depth == keyBytes)
+            {
+                if (node->EndLeaf != nullptr)
+                {
+                    return false;
+                }
+
+                node->EndLeaf = NewLeaf(key, value);
+                ++m_size;
+                return true;
+            }
+
+            const uint8_t byte = Detail::ArtKeyByte(chars, depth);
+            void** next = FindChild(node, byte);
+            if (next == nullptr)
+            {
+                AddChild(ref, node, byte, TagLeaf(NewLeaf(key, value)));
+                ++m_size;
+                return true;
+            }
+
+            ref = next;
+            ++depth;
+        }
+    }
+
+    // Look up the [start, finish) key.
+    // Returns a pointer to its value, or nullptr if the key is not in the index.
+    ValueT* Find(const CharT* start, const CharT* finish) noexcept
+    {
+        const size_t length = finish - start;
+        const size_t keyBytes = length * sizeof(CharT);
+
+        void* child = m_root;
+        size_t depth = 0;
+        while (child != nullptr)
+        {
+            if (IsLeaf(child))
+            {
+                Leaf* leaf = AsLeaf(child);
+                return (Detail::ArtCompareKeys(leaf->Key.Str(), leaf->Key.Length(),
+                                               start, length) == 0) ? &leaf->Value : nullptr;
+            }
+
+            Node* node = AsNode(child);
+            if (!MatchPrefix(node, start, keyBytes, depth))
+            {
+                return nullptr;
+            }
+            depth += node->PrefixLength;
+
+            if (depth == keyBytes)
+            {
+                return (node->EndLeaf != nullptr) ? &node->EndLeaf->Value : nullptr;
+            }
+
+            void** next = FindChild(node, Detail::ArtKeyByte(start, depth));
+            child = (next != nullptr) ? *next : nullptr;
+            ++depth;
+        }
+
+        return nullptr;
+    }
+
+    const ValueT* Find(const CharT* start, const CharT* finish) const noexcept
+    {
+        return const_cast<BasicArtIndex*>(this)->Find(start, finish);
+    }
+
+    ValueT* Find(const String& key) noexcept
+    {
+        return Find(key.Str(), key.Str() + key.Length());
+    }
+
+    const ValueT* Find(const String& key) const noexcept
+    {
+        return Find(key.Str(), key.Str() + key.Length());
+    }
+
+    // Call func(const String& key, ValueT& value) for each key starting with
+    // the [start, finish) prefix, in key order.
+    template <typename Func>
+    void ForEachWithPrefix(const CharT* start, const CharT* finish, Func func)
+    {
+        const size_t length = finish - start;
+        const size_t prefixBytes = length * sizeof(CharT);
+        auto visit = [&func](Leaf& leaf)
+        {
+            func(static_cast<const String&>(leaf.Key), leaf.Value);
+            return true;
+        };
+
+        void* child = m_root;
+        size_t depth = 0;
+        while (child != nullptr)
+        {
+            if (IsLeaf(child))
+            {
+                Leaf* leaf = AsLeaf(child);
+                if (leaf->Key.Length() >= length
+                    && Detail::ArtCompareKeys(leaf->Key.Str(), length, start, length) == 0)
+                {
+                    visit(*leaf);
+                }
+                return;
+            }
+
+            // The prefix can end inside a compressed path
+            Node* node = AsNode(child);
+            for (size_t i = 0; i < node->PrefixLength; ++i)
+            {
+                if (depth + i == prefixBytes)
+                {
+                    Walk(node, visit);
+                    return;
+                }
+
+                if (PrefixByte(node, i) != Detail::ArtKeyByte(start, depth + i))
+                {
+                    return;
+                }
+            }
+            depth += node->PrefixLength;
+
+            if (depth == prefixBytes)
+            {
+                Walk(node, visit);
+                return;
+            }
+
+            void** next = FindChild(node, Detail::ArtKeyByte(start, depth));
+            child = (next != nullptr) ? *next : nullptr;
+            ++depth;
+        }
+    }
+
+    template <typename Func>
+    void ForEachWithPrefix(const String& prefix, Func func)
+    {
+        ForEachWithPrefix(prefix.Str(), prefix.Str() + prefix.Length(), func);
+    }
+
+    // Call func(const String& key, ValueT& value) for each key in the [first, last)
+    // range, in key order.
+    template <typename Func>
+    void ForEachInRange(const String& first, const String& last, Func func)
+    {
+        auto visit = [&func, &last](Leaf& leaf)
+        {
+            if (Detail::ArtCompareKeys(leaf.Key.Str(), leaf.Key.Length(),
+                                       last.Str(), last.Length()) >= 0)
+            {
+                return false;
+            }
+
+            func(static_cast<const String&>(leaf.Key), leaf.Value);
+            return true;
+        };
+
+        if (m_root != nullptr)
+        {
+            WalkFrom(m_root, 0, first.Str(), first.Length(), visit);
+        }
+    }
+
+    // Call func(const String& key, ValueT& value) for all the keys, in key order.
+    template <typename Func>
+    void ForEach(Func func)
+    {
+        auto visit = [&func](Leaf& leaf)
+        {
+            func(static_cast<const String&>(leaf.Key), leaf.Value);
+            return true;
+        };
+
+        if (m_root != nullptr)
+        {
+            Walk(m_root, visit);
+        }
+    }
+
+
+private:
+    enum NodeType : uint8_t
+    {
+        kNode4,
+        kNode16,
+        kNode48,
+        kNode256
+    };
+
+    struct Leaf
+    {
+        String Key;
+        ValueT Value;
+    };
+
+    struct Node
+    {
+        NodeType Type{};
+        uint16_t Count{};           // Number of children
+        uint32_t PrefixLength{};    // Compressed path, in bytes
+
+        // The compressed path bytes are the [PrefixStart, PrefixStart + PrefixLength)
+        // bytes of a key in the subtree (in the pool); PrefixStart is the node depth,
+        // so paths are matched comparing two keys at the same offsets
+        const CharT* PrefixKey{};
+        size_t PrefixStart{};
+
+        Leaf* EndLeaf{};            // The key ending at this node, if any
+    };
+
+    // Children are sorted by key byte
+    struct Node4 : Node
+    {
+        uint8_t Keys[4]{};
+        void* Children[4]{};
+    };
+
+    struct Node16 : Node
+    {
+        uint8_t Keys[16]{};
+        void* Children[16]{};
+    };
+
+    // ChildIndex maps a key byte to its child slot + 1 (0 for no child)
+    struct Node48 : Node
+    {
+        uint8_t ChildIndex[256]{};
+        void* Children[48]{};
+    };
+
+    struct Node256 : Node
+    {
+        void* Children[256]{};
+    };
+
+    AllocatorType* m_allocator;
+    void* m_root{};     // Node, or tagged leaf
+    size_t m_size{};
+
+
+    //
+    // Children are either nodes, or leaves tagged with the low pointer bit
+    //
+
+    static bool IsLeaf(const void* child) noexcept
+    {
+        return (reinterpret_cast<uintptr_t>(child) & 1) != 0;
+    }
+
+    static Leaf* AsLeaf(void* child) noexcept
+    {
+        return reinterpret_cast<Leaf*>(reinterpret_cast<uintptr_t>(child) & ~uintptr_t(1));
+    }
+
+    static void* TagLeaf(Leaf* leaf) noexcept
+    {
+        return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(leaf) | 1);
+    }
+
+    static Node* AsNode(void* child) noexcept
+    {
+        return static_cast<Node*>(child);
+    }
+
+    Leaf* NewLeaf(const String& key, const ValueT& value)
+    {
+        void* memory = m_allocator->AllocBytes(sizeof(Leaf), alignof(Leaf));
+        return new (memory) Leaf{ key, value };
+    }
+
+    template <typename NodeT>
+    NodeT* NewNode(NodeType type)
+    {
+        void* memory = m_allocator->AllocBytes(sizeof(NodeT), alignof(NodeT));
+        NodeT* node = new (memory) NodeT();
+        node->Type = type;
+        return node;
+    }
+
+    static void SetPrefix(Node* node, const CharT* key, size_t start, size_t length) noexcept
+    {
+        node->PrefixKey = key;
+        node->PrefixStart = start;
+        node->PrefixLength = static_cast<uint32_t>(length);
+    }
+
+    static uint8_t PrefixByte(const Node* node, size_t i) noexcept
+    {
+        return Detail::ArtKeyByte(node->PrefixKey, node->PrefixStart + i);
+    }
+
+    // Check the compressed path of the node against the key bytes at 'depth'
+    // (the node PrefixStart).
+    static bool MatchPrefix(const Node* node, const CharT* key, size_t keyBytes,
+                            size_t depth) noexcept
+    {
+        const size_t last = depth + node->PrefixLength;
+        return last <= keyBytes
+            && Detail::ArtMismatch(node->PrefixKey, key, depth, last) == last;
+    }
+
+    // Pointer to the child slot for the key byte, or nullptr if there's no such child.
+    static void** FindChild(Node* node, uint8_t byte) noexcept
+    {
+        switch (node->Type)
+        {
+        case kNode4:
+        {
+            Node4* n = static_cast<Node4*>(node);
+            for (size_t i = 0; i < n->Count; ++i)
+            {
+                if (n->Keys[i] == byte)
+                {
+                    return &n->Children[i];
+                }
+            }
+            return nullptr;
+        }
+
+        case kNode16:
+        {
+            Node16* n = static_cast<Node16*>(node);
+#ifdef STRINGPOOL_HAS_SSE2
+            // Compare the key byte with all the 16 keys at once
+            const __m128i keys = _mm_loadu_si128(reinterpret_cast<const __m128i*>(n->Keys));
+            const __m128i equal = _mm_cmpeq_epi8(keys, _mm_set1_epi8(static_cast<char>(byte)));
+            const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(equal))
+                & ((1u << n->Count) - 1);
+            return (mask != 0) ? &n->Children[Detail::LowestSetBit(mask)] : nullptr;
+#else
+            for (size_t i = 0; i < n->Count; ++i)
+            {
+                if (n->Keys[i] == byte)
+                {
+                    return &n->Children[i];
+                }
+            }
+            return nullptr;
+#endif
+        }
+
+        case kNode48:
+        {
+            Node48* n = static_cast<Node48*>(node);
+            const uint8_t index = n->ChildIndex[byte];
+            return (index != 0) ? &n->Children[index - 1] : nullptr;
+        }
+
+        default:
+        {
+            Node256* n = static_cast<Node256*>(node);
+            return (n->Children[byte] != nullptr) ? &n->Children[byte] : nullptr;
+        }
+        }
+    }
+
+    // Insert a sorted key and child into the Keys/Children arrays of a Node4 or Node16.
+    template <typename NodeT>
+    static void InsertSorted(NodeT* node, uint8_t byte, void* child) noexcept
+    {
+        size_t i = 0;
+        while (i < node->Count && node->Keys[i] < byte)
+        {
+            ++i;
+        }
+
+        memmove(node->Keys + i + 1, node->Keys + i, node->Count - i);
+        memmove(node->Children + i + 1, node->Children + i, (node->Count - i) * sizeof(void*));
+        node->Keys[i] = byte;
+        node->Children[i] = child;
+        ++node->Count;
+    }
+
+    // Copy the header of a node into its grown replacement.
+    static void CopyHeader(Node* to, const Node* from, NodeType type) noexcept
+    {
+        *to = *from;
+        to->Type = type;
+    }
+
+    // Add a child to the node referenced by 'ref', growing it (and updating 'ref')
+    // if it's full.
+    void AddChild(void** ref, Node* node, uint8_t byte, void* child)
+    {
+        switch (node->Type)
+        {
+        case kNode4:
+        {
+            Node4* n = static_cast<Node4*>(node);
+            if (n->Count < 4)
+            {
+                InsertSorted(n, byte, child);
+                return;
+            }
+
+            Node16* grown = NewNode<Node16>(kNode16);
+            CopyHeader(grown, n, kNode16);
+            memcpy(grown->Keys, n->Keys, sizeof(n->Keys));
+            memcpy(grown->Children, n->Children, sizeof(n->Children));
+            *ref = grown;
+            InsertSorted(grown, byte, child);
+            return;
+        }
+
+        case kNode16:
+        {
+            Node16* n = static_cast<Node16*>(node);
+            if (n->Count < 16)
+            {
+                InsertSorted(n, byte, child);
+                return;
+            }
+
+            Node48* grown = NewNode<Node48>(kNode48);
+            CopyHeader(grown, n, kNode48);
+            for (size_t i = 0; i < 16; ++i)
+            {
+                grown->ChildIndex[n->Keys[i]] = static_cast<uint8_t>(i + 1);
+                grown->Children[i] = n->Children[i];
+            }
+            *ref = grown;
+            AddChild(ref, grown, byte, child);
+            return;
+        }
+
+        case kNode48:
+        {
+            Node48* n = static_cast<Node48*>(node);
+            if (n->Count < 48)
+            {
+                // Keys are never removed, so the free slots are at the end
+                n->Children[n->Count] = child;
+                n->ChildIndex[byte] = static_cast<uint8_t>(n->Count + 1);
+                ++n->Count;
+                return;
+            }
+
+            Node256* grown = NewNode<Node256>(kNode256);
+            CopyHeader(grown, n, kNode256);
+            for (size_t b = 0; b < 256; ++b)
+            {
+                if (n->ChildIndex[b] != 0)
+                {
+                    grown->Children[b] = n->Children[n->ChildIndex[b] - 1];
+                }
+            }
+            *ref = grown;
+            AddChild(ref, grown, byte, child);
+            return;
+        }
+
+        default:
+        {
+            Node256* n = static_cast<Node256*>(node);
+            n->Children[byte] = child;
+            ++n->Count;
+            return;
+        }
+        }
+    }
+
+    // Add a leaf to a node, whose compressed path ends at 'depth'.
+    void AttachLeaf(void** ref, Node* node, size_t depth, Leaf* leaf)
+    {
+        if (leaf->Key.Length() * sizeof(CharT) == depth)
+        {
+            node->EndLeaf = leaf;
+        }
+        else
+        {
+            AddChild(ref, node, Detail::ArtKeyByte(leaf->Key.Str(), depth), TagLeaf(leaf));
+        }
+    }
+
+    // Call func(keyByte, child) for the children of the node, in key order,
+    // until it returns false.
+    template <typename Func>
+    static bool ForEachChild(Node* node, Func&& func)
+    {
+        switch (node->Type)
+        {
+        case kNode4:
+        {
+            Node4* n = static_cast<Node4*>(node);
+            for (size_t i = 0; i < n->Count; ++i)
+            {
+                if (!func(n->Keys[i], n->Children[i]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        case kNode16:
+        {
+            Node16* n = static_cast<Node16*>(node);
+            for (size_t i = 0; i < n->Count; ++i)
+            {
+                if (!func(n->Keys[i], n->Children[i]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        case kNode48:
+        {
+            Node48* n = static_cast<Node48*>(node);
+            for (size_t b = 0; b < 256; ++b)
+            {
+                if (n->ChildIndex[b] != 0
+                    && !func(static_cast<uint8_t>(b), n->Children[n->ChildIndex[b] - 1]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        default:
+        {
+            Node256* n = static_cast<Node256*>(node);
+            for (size_t b = 0; b < 256; ++b)
+            {
+                if (n->Children[b] != nullptr
+                    && !func(static_cast<uint8_t>(b), n->Children[b]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        }
+    }
+
+    // Visit the leaves of a subtree in key order, until visit returns false.
+    template <typename Visitor>
+    static bool Walk(void* child, Visitor& visit)
+    {
+        if (IsLeaf(child))
+        {
+            return visit(*AsLeaf(child));
+        }
+
+        // A key ending at this node precedes the longer ones
+        Node* node = AsNode(child);
+        if (node->EndLeaf != nullptr && !visit(*node->EndLeaf))
+        {
+            return false;
+        }
+
+        return ForEachChild(node, [&visit](uint8_t, void* c)
+        {
+            return Walk(c, visit);
+        });
+    }
+
+    // Visit the leaves of a subtree not less than the 'low' key, in key order,
+    // until visit returns false.
+    template <typename Visitor>
+    static bool WalkFrom(void* child, size_t depth, const CharT* low, size_t lowLength,
+                         Visitor& visit)
+    {
+        if (IsLeaf(child))
+        {
+            Leaf* leaf = AsLeaf(child);
+            if (Detail::ArtCompareKeys(leaf->Key.Str(), leaf->Key.Length(), low, lowLength) < 0)
+            {
+                return true;
+            }
+            return visit(*leaf);
+        }
+
+        const size_t lowBytes = lowLength * sizeof(CharT);
+        Node* node = AsNode(child);
+        for (size_t i = 0; i < node->PrefixLength; ++i)
+        {
+            // The subtree keys extend 'low', or are greater
+            if (depth + i == lowBytes)
+            {
+                return Walk(node, visit);
+            }
+
+            const uint8_t nodeByte = PrefixByte(node, i);
+            const uint8_t lowByte = Detail::ArtKeyByte(low, depth + i);
+            if (nodeByte != lowByte)
+            {
+                return (nodeByte < lowByte) ? true : Walk(node, visit);
+            }
+        }
+        depth += node->PrefixLength;
+
+        if (depth == lowBytes)
+        {
+            return Walk(node, visit);
+        }
+
+        // Here the key ending at this node (if any) is a proper prefix of 'low'
+        const uint8_t lowByte = Detail::ArtKeyByte(low, depth);
+        return ForEachChild(node, [&](uint8_t byte, void* c)
+        {
+            if (byte < lowByte)
+            {
+                return true;
+            }
+            return (byte == lowByte) ? WalkFrom(c, depth + 1, low, lowLength, visit)
+                                     : Walk(c, visit);
+        });
+    }
+};
+
+// Adaptive radix tree index of wchar_t strings.
+template <typename ValueT>
+using ArtIndex = BasicArtIndex<wchar_t, ValueT>;
+
+} // namespace StringPool
+
+
+#endif // INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_ART_H
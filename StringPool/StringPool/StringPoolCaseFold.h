@@ -0,0 +1,515 @@
+#ifndef INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_CASEFOLD_H
+#define INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_CASEFOLD_H
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//
+// Case folding kernels used by the string pool 
+// (BasicAllocator::AllocStringFolded, and the case-insensitive comparison functors).
+//
+// Implements the Unicode *simple* case folding (CaseFolding.txt, status C and S):
+// each code point folds to a single code point, so folding never changes 
+// the length of UTF-16 and UTF-32 strings; in UTF-8, a few code points take 
+// one more byte when folded (e.g. U+023A, from 2 to 3 bytes).
+// 
+// Runs of ASCII characters are folded 16 at a time with SSE2, when available;
+// the other code points are folded with a lookup in a table of ranges.
+// Invalid sequences (e.g. unpaired surrogates) are copied unchanged.
+//
+// Copyright (C) by Giovanni Dicanio
+//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <algorithm>    // For std::upper_bound
+#include <cstddef>      // For size_t
+#include <cstdint>      // For uint8_t, uint16_t, uint32_t, int32_t
+
+#include "StringPoolSimd.h"
+#include "StringPoolUtf8.h"
+
+
+namespace StringPool
+{
+namespace Detail
+{
+
+// A range of code points with the same folding offset: the code points 
+// First, First + Stride, ... (Count of them) fold to themselves plus Delta.
+struct CaseFoldRange
+{
+    uint32_t First;
+    uint8_t Count;
+    uint8_t Stride;
+    int32_t Delta;
+};
+
+// Simple case folding of a non-ASCII code point.
+inline char32_t FoldNonAscii(char32_t cp) noexcept
+{
+    // Simple case folding ranges (code points >= 0x80), from the Unicode 14.0 
+    // Character Database
+    static const CaseFoldRange kRanges[] = {
+    { 0x000B5,  1, 1,    775 },
+    { 0x000C0, 23, 1,     32 },
+    { 0x000D8,  7, 1,     32 },
+    { 0x00100, 24, 2,      1 },
+    { 0x00132,  3, 2,      1 },
+    { 0x00139,  8, 2,      1 },
+    { 0x0014A, 23, 2,      1 },
+    { 0x00178,  1, 1,   -121 },
+    { 0x00179,  3, 2,      1 },
+    { 0x0017F,  1, 1,   -268 },
+    { 0x00181,  1, 1,    210 },
+    { 0x00182,  2, 2,      1 },
+    { 0x00186,  1, 1,    206 },
+    { 0x00187,  1, 1,      1 },
+    { 0x00189,  2, 1,    205 },
+    { 0x0018B,  1, 1,      1 },
+    { 0x0018E,  1, 1,     79 },
+    { 0x0018F,  1, 1,    202 },
+    { 0x00190,  1, 1,    203 },
+    { 0x00191,  1, 1,      1 },
+    { 0x00193,  1, 1,    205 },
+    { 0x00194,  1, 1,    207 },
+    { 0x00196,  1, 1,    211 },
+    { 0x00197,  1, 1,    209 },
+    { 0x00198,  1, 1,      1 },
+    { 0x0019C,  1, 1,    211 },
+    { 0x0019D,  1, 1,    213 },
+    { 0x0019F,  1, 1,    214 },
+    { 0x001A0,  3, 2,      1 },
+    { 0x001A6,  1, 1,    218 },
+    { 0x001A7,  1, 1,      1 },
+    { 0x001A9,  1, 1,    218 },
+    { 0x001AC,  1, 1,      1 },
+    { 0x001AE,  1, 1,    218 },
+    { 0x001AF,  1, 1,      1 },
+    { 0x001B1,  2, 1,    217 },
+    { 0x001B3,  2, 2,      1 },
+    { 0x001B7,  1, 1,    219 },
+    { 0x001B8,  1, 1,      1 },
+    { 0x001BC,  1, 1,      1 },
+    { 0x001C4,  1, 1,      2 },
+    { 0x001C5,  1, 1,      1 },
+    { 0x001C7,  1, 1,      2 },
+    { 0x001C8,  1, 1,      1 },
+    { 0x001CA,  1, 1,      2 },
+    { 0x001CB,  9, 2,      1 },
+    { 0x001DE,  9, 2,      1 },
+    { 0x001F1,  1, 1,      2 },
+    { 0x001F2,  2, 2,      1 },
+    { 0x001F6,  1, 1,    -97 },
+    { 0x001F7,  1, 1,    -56 },
+    { 0x001F8, 20, 2,      1 },
+    { 0x00220,  1, 1,   -130 },
+    { 0x00222,  9, 2,      1 },
+    { 0x0023A,  1, 1,  10795 },
+    { 0x0023B,  1, 1,      1 },
+    { 0x0023D,  1, 1,   -163 },
+    { 0x0023E,  1, 1,  10792 },
+    { 0x00241,  1, 1,      1 },
+    { 0x00243,  1, 1,   -195 },
+    { 0x00244,  1, 1,     69 },
+    { 0x00245,  1, 1,     71 },
+    { 0x00246,  5, 2,      1 },
+    { 0x00345,  1, 1,    116 },
+    { 0x00370,  2, 2,      1 },
+    { 0x00376,  1, 1,      1 },
+    { 0x0037F,  1, 1,    116 },
+    { 0x00386,  1, 1,     38 },
+    { 0x00388,  3, 1,     37 },
+    { 0x0038C,  1, 1,     64 },
+    { 0x0038E,  2, 1,     63 },
+    { 0x00391, 17, 1,     32 },
+    { 0x003A3,  9, 1,     32 },
+    { 0x003C2,  1, 1,      1 },
+    { 0x003CF,  1, 1,      8 },
+    { 0x003D0,  1, 1,    -30 },
+    { 0x003D1,  1, 1,    -25 },
+    { 0x003D5,  1, 1,    -15 },
+    { 0x003D6,  1, 1,    -22 },
+    { 0x003D8, 12, 2,      1 },
+    { 0x003F0,  1, 1,    -54 },
+    { 0x003F1,  1, 1,    -48 },
+    { 0x003F4,  1, 1,    -60 },
+    { 0x003F5,  1, 1,    -64 },
+    { 0x003F7,  1, 1,      1 },
+    { 0x003F9,  1, 1,     -7 },
+    { 0x003FA,  1, 1,      1 },
+    { 0x003FD,  3, 1,   -130 },
+    { 0x00400, 16, 1,     80 },
+    { 0x00410, 32, 1,     32 },
+    { 0x00460, 17, 2,      1 },
+    { 0x0048A, 27, 2,      1 },
+    { 0x004C0,  1, 1,     15 },
+    { 0x004C1,  7, 2,      1 },
+    { 0x004D0, 48, 2,      1 },
+    { 0x00531, 38, 1,     48 },
+    { 0x010A0, 38, 1,   7264 },
+    { 0x010C7,  1, 1,   7264 },
+    { 0x010CD,  1, 1,   7264 },
+    { 0x013F8,  6, 1,     -8 },
+    { 0x01C80,  1, 1,  -6222 },
+    { 0x01C81,  1, 1,  -6221 },
+    { 0x01C82,  1, 1,  -6212 },
+    { 0x01C83,  2, 1,  -6210 },
+    { 0x01C85,  1, 1,  -6211 },
+    { 0x01C86,  1, 1,  -6204 },
+    { 0x01C87,  1, 1,  -6180 },
+    { 0x01C88,  1, 1,  35267 },
+    { 0x01C90, 43, 1,  -3008 },
+    { 0x01CBD,  3, 1,  -3008 },
+    { 0x01E00, 75, 2,      1 },
+    { 0x01E9B,  1, 1,    -58 },
+    { 0x01E9E,  1, 1,  -7615 },
+    { 0x01EA0, 48, 2,      1 },
+    { 0x01F08,  8, 1,     -8 },
+    { 0x01F18,  6, 1,     -8 },
+    { 0x01F28,  8, 1,     -8 },
+    { 0x01F38,  8, 1,     -8 },
+    { 0x01F48,  6, 1,     -8 },
+    { 0x01F59,  4, 2,     -8 },
+    { 0x01F68,  8, 1,     -8 },
+    { 0x01F88,  8, 1,     -8 },
+    { 0x01F98,  8, 1,     -8 },
+    { 0x01FA8,  8, 1,     -8 },
+    { 0x01FB8,  2, 1,     -8 },
+    { 0x01FBA,  2, 1,    -74 },
+    { 0x01FBC,  1, 1,     -9 },
+    { 0x01FBE,  1, 1,  -7173 },
+    { 0x01FC8,  4, 1,    -86 },
+    { 0x01FCC,  1, 1,     -9 },
+    { 0x01FD8,  2, 1,     -8 },
+    { 0x01FDA,  2, 1,   -100 },
+    { 0x01FE8,  2, 1,     -8 },
+    { 0x01FEA,  2, 1,   -112 },
+    { 0x01FEC,  1, 1,     -7 },
+    { 0x01FF8,  2, 1,   -128 },
+    { 0x01FFA,  2, 1,   -126 },
+    { 0x01FFC,  1, 1,     -9 },
+    { 0x02126,  1, 1,  -7517 },
+    { 0x0212A,  1, 1,  -8383 },
+    { 0x0212B,  1, 1,  -8262 },
+    { 0x02132,  1, 1,     28 },
+    { 0x02160, 16, 1,     16 },
+    { 0x02183,  1, 1,      1 },
+    { 0x024B6, 26, 1,     26 },
+    { 0x02C00, 48, 1,     48 },
+    { 0x02C60,  1, 1,      1 },
+    { 0x02C62,  1, 1, -10743 },
+    { 0x02C63,  1, 1,  -3814 },
+    { 0x02C64,  1, 1, -10727 },
+    { 0x02C67,  3, 2,      1 },
+    { 0x02C6D,  1, 1, -10780 },
+    { 0x02C6E,  1, 1, -10749 },
+    { 0x02C6F,  1, 1, -10783 },
+    { 0x02C70,  1, 1, -10782 },
+    { 0x02C72,  1, 1,      1 },
+    { 0x02C75,  1, 1,      1 },
+    { 0x02C7E,  2, 1, -10815 },
+    { 0x02C80, 50, 2,      1 },
+    { 0x02CEB,  2, 2,      1 },
+    { 0x02CF2,  1, 1,      1 },
+    { 0x0A640, 23, 2,      1 },
+    { 0x0A680, 14, 2,      1 },
+    { 0x0A722,  7, 2,      1 },
+    { 0x0A732, 31, 2,      1 },
+    { 0x0A779,  2, 2,      1 },
+    { 0x0A77D,  1, 1, -35332 },
+    { 0x0A77E,  5, 2,      1 },
+    { 0x0A78B,  1, 1,      1 },
+    { 0x0A78D,  1, 1, -42280 },
+    { 0x0A790,  2, 2,      1 },
+    { 0x0A796, 10, 2,      1 },
+    { 0x0A7AA,  1, 1, -42308 },
+    { 0x0A7AB,  1, 1, -42319 },
+    { 0x0A7AC,  1, 1, -42315 },
+    { 0x0A7AD,  1, 1, -42305 },
+    { 0x0A7AE,  1, 1, -42308 },
+    { 0x0A7B0,  1, 1, -42258 },
+    { 0x0A7B1,  1, 1, -42282 },
+    { 0x0A7B2,  1, 1, -42261 },
+    { 0x0A7B3,  1, 1,    928 },
+    { 0x0A7B4,  8, 2,      1 },
+    { 0x0A7C4,  1, 1,    -48 },
+    { 0x0A7C5,  1, 1, -42307 },
+    { 0x0A7C6,  1, 1, -35384 },
+    { 0x0A7C7,  2, 2,      1 },
+    { 0x0A7D0,  1, 1,      1 },
+    { 0x0A7D6,  2, 2,      1 },
+    { 0x0A7F5,  1, 1,      1 },
+    { 0x0AB70, 80, 1, -38864 },
+    { 0x0FF21, 26, 1,     32 },
+    { 0x10400, 40, 1,     40 },
+    { 0x104B0, 36, 1,     40 },
+    { 0x10570, 11, 1,     39 },
+    { 0x1057C, 15, 1,     39 },
+    { 0x1058C,  7, 1,     39 },
+    { 0x10594,  2, 1,     39 },
+    { 0x10C80, 51, 1,     64 },
+    { 0x118A0, 32, 1,     32 },
+    { 0x16E40, 32, 1,     32 },
+    { 0x1E900, 34, 1,     34 },
+    };
+
+    const CaseFoldRange* const end = kRanges + (sizeof(kRanges) / sizeof(kRanges[0]));
+    const CaseFoldRange* range = std::upper_bound(kRanges, end, cp, 
+        [](char32_t c, const CaseFoldRange& r) { return c < r.First; });
+    if (range == kRanges)
+    {
+        return cp;
+    }
+    --range;
+
+    const uint32_t offset = static_cast<uint32_t>(cp) - range->First;
+    if (offset % range->Stride != 0 || offset / range->Stride >= range->Count)
+    {
+        return cp;
+    }
+
+    return static_cast<char32_t>(static_cast<int32_t>(cp) + range->Delta);
+}
+
+// Simple case folding of a code point.
+inline char32_t FoldCodePoint(char32_t cp) noexcept
+{
+    if (cp < 0x80)
+    {
+        return (cp - U'A' < 26) ? cp + (U'a' - U'A') : cp;
+    }
+    return FoldNonAscii(cp);
+}
+
+
+#ifdef STRINGPOOL_HAS_SSE2
+
+// Fold 16 ASCII bytes: add 0x20 to the ones in ['A', 'Z'].
+inline __m128i FoldAsciiBytes(__m128i bytes) noexcept
+{
+    const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('A' - 1)),
+                                        _mm_cmplt_epi8(bytes, _mm_set1_epi8('Z' + 1)));
+    return _mm_or_si128(bytes, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+#endif // STRINGPOOL_HAS_SSE2
+
+
+//
+// Per-encoding helpers: each one processes the code point starting at s[i] (i < length),
+// advancing 'i' past it.
+//
+
+// Fold the code point at s[i] into 'out', returning the end of the written characters.
+template <typename CharT>
+CharT* FoldNext(const CharT* s, size_t length, size_t& i, CharT* out,
+                std::integral_constant<size_t, 1>) noexcept
+{
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(s);
+
+    char32_t cp;
+    const size_t size = p[i] < 0x80 ? 1 : DecodeUtf8(p + i, p + length, cp);
+    if (size == 1)
+    {
+        *out++ = static_cast<CharT>(FoldCodePoint(p[i++]));
+        return out;
+    }
+
+    if (size == 0)
+    {
+        // Invalid UTF-8: copy the byte unchanged
+        *out++ = s[i++];
+        return out;
+    }
+
+    i += size;
+    return reinterpret_cast<CharT*>(
+        EncodeUtf8(FoldNonAscii(cp), reinterpret_cast<uint8_t*>(out)));
+}
+
+template <typename CharT>
+CharT* FoldNext(const CharT* s, size_t length, size_t& i, CharT* out,
+                std::integral_constant<size_t, 2>) noexcept
+{
+    const char32_t unit = static_cast<uint16_t>(s[i]);
+    if (unit >= 0xD800 && unit <= 0xDBFF && i + 1 < length)
+    {
+        const char32_t low = static_cast<uint16_t>(s[i + 1]);
+        if (low >= 0xDC00 && low <= 0xDFFF)
+        {
+            // Surrogate pair: supplementary code points fold to supplementary ones
+            i += 2;
+            return EncodeCodePoint(
+                FoldNonAscii(0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00)),
+                nullptr, 0, out, std::integral_constant<size_t, 2>{});
+        }
+    }
+
+    // BMP code points fold to BMP code points, and unpaired surrogates to themselves
+    ++i;
+    *out++ = static_cast<CharT>(FoldCodePoint(unit));
+    return out;
+}
+
+template <typename CharT>
+CharT* FoldNext(const CharT* s, size_t /* length */, size_t& i, CharT* out,
+                std::integral_constant<size_t, 4>) noexcept
+{
+    const char32_t cp = static_cast<uint32_t>(s[i++]);
+    *out++ = static_cast<CharT>(cp <= 0x10FFFF ? FoldCodePoint(cp) : cp);
+    return out;
+}
+
+// Return the folded code point at s[i], for case-insensitive comparisons and hashing.
+// Invalid sequences are returned as distinct values that don't match any valid 
+// code point (e.g. an invalid UTF-8 byte b becomes the lone surrogate 0xDC00 + b).
+template <typename CharT>
+char32_t NextFolded(const CharT* s, size_t length, size_t& i,
+                    std::integral_constant<size_t, 1>) noexcept
+{
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(s);
+    if (p[i] < 0x80)
+    {
+        return FoldCodePoint(p[i++]);
+    }
+
+    char32_t cp;
+    const size_t size = DecodeUtf8(p + i, p + length, cp);
+    if (size == 0)
+    {
+        return 0xDC00 + p[i++];
+    }
+
+    i += size;
+    return FoldNonAscii(cp);
+}
+
+template <typename CharT>
+char32_t NextFolded(const CharT* s, size_t length, size_t& i,
+                    std::integral_constant<size_t, 2>) noexcept
+{
+    const char32_t unit = static_cast<uint16_t>(s[i]);
+    if (unit >= 0xD800 && unit <= 0xDBFF && i + 1 < length)
+    {
+        const char32_t low = static_cast<uint16_t>(s[i + 1]);
+        if (low >= 0xDC00 && low <= 0xDFFF)
+        {
+            i += 2;
+            return FoldNonAscii(0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00));
+        }
+    }
+
+    ++i;
+    return FoldCodePoint(unit);
+}
+
+template <typename CharT>
+char32_t NextFolded(const CharT* s, size_t /* length */, size_t& i,
+                    std::integral_constant<size_t, 4>) noexcept
+{
+    const char32_t cp = static_cast<uint32_t>(s[i++]);
+    return cp <= 0x10FFFF ? FoldCodePoint(cp) : cp;
+}
+
+
+//----------------------------------------------------------------------------------------
+// Folding functions
+//----------------------------------------------------------------------------------------
+
+// Maximum number of characters of the case-folded copy of 'length' characters.
+template <typename CharT>
+size_t MaxFoldedLength(size_t length) noexcept
+{
+    // In UTF-8, a folded code point takes at most 3/2 of the original bytes
+    return sizeof(CharT) == 1 ? length + (length + 1) / 2 : length;
+}
+
+// Copy s[0, length) into 'dest' with simple case folding, in a single pass.
+// 'dest' must have room for MaxFoldedLength(length) characters.
+// Returns the number of characters written.
+template <typename CharT>
+size_t FoldCase(const CharT* s, size_t length, CharT* dest) noexcept
+{
+    CharT* out = dest;
+    size_t i = 0;
+
+    while (i < length)
+    {
+#ifdef STRINGPOOL_HAS_SSE2
+        // Fold ASCII runs 16 characters at a time
+        __m128i bytes;
+        while (length - i >= 16 && LoadAscii(s + i, bytes, EncodingOf<CharT>{}))
+        {
+            StoreAscii(FoldAsciiBytes(bytes), out, EncodingOf<CharT>{});
+            i += 16;
+            out += 16;
+        }
+
+        if (i == length)
+        {
+            break;
+        }
+#endif
+
+        out = FoldNext(s, length, i, out, EncodingOf<CharT>{});
+    }
+
+    return out - dest;
+}
+
+// Compare a[0, lengthA) and b[0, lengthB) ignoring case: the folded code points 
+// are compared in code point order.
+// Returns a negative value, 0 or a positive value, like memcmp.
+template <typename CharT>
+int CompareFolded(const CharT* a, size_t lengthA, const CharT* b, size_t lengthB) noexcept
+{
+    size_t i = 0;
+    size_t j = 0;
+
+    while (i < lengthA && j < lengthB)
+    {
+        // Identical characters fold to the same code point, if they're whole ones
+        if (a[i] == b[j] && static_cast<uint32_t>(a[i]) < 0x80)
+        {
+            ++i;
+            ++j;
+            continue;
+        }
+
+        const char32_t ca = NextFolded(a, lengthA, i, EncodingOf<CharT>{});
+        const char32_t cb = NextFolded(b, lengthB, j, EncodingOf<CharT>{});
+        if (ca != cb)
+        {
+            return ca < cb ? -1 : 1;
+        }
+    }
+
+    if (i < lengthA)
+        return 1;
+
+    if (j < lengthB)
+        return -1;
+
+    return 0;
+}
+
+// Hash of the folded code points of s[0, length) (64-bit FNV-1a, truncated to size_t).
+template <typename CharT>
+size_t HashFolded(const CharT* s, size_t length) noexcept
+{
+    uint64_t hash = 14695981039346656037ULL;
+
+    size_t i = 0;
+    while (i < length)
+    {
+        hash ^= NextFolded(s, length, i, EncodingOf<CharT>{});
+        hash *= 1099511628211ULL;
+    }
+
+    return static_cast<size_t>(hash);
+}
+
+} // namespace Detail
+} // namespace StringPool
+
+
+#endif // INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_CASEFOLD_H
@@ -0,0 +1,607 @@
+#ifndef INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_COMPRESSION_H
+#define INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_COMPRESSION_H
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//
+// Compressed string pool (StringPool::CompressedPool), to keep more strings in memory
+// when the text is repetitive.
+//
+// The compression is FSST-style (Fast Static Symbol Table): a table of up to 255
+// symbols of 1 to 8 bytes is trained on a sample of the strings, then each string
+// is stored as a sequence of 1-byte codes, each one standing for a symbol
+// (or escaping a literal byte).
+// Each string is compressed on its own, so it can be decompressed independently
+// (random access) with a simple table lookup and an 8-byte copy per code.
+//
+// Strings compressed with the same table can be compared for equality without
+// decompressing them, as equal strings always get the same codes.
+//
+// Copyright (C) by Giovanni Dicanio
+//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "StringPool.h"
+
+#include <algorithm>    // For std::sort
+#include <cstdint>      // For uint8_t, uint64_t
+#include <cstring>      // For memcpy, memcmp
+#include <map>          // For std::map
+#include <stdexcept>    // For std::logic_error
+#include <string>       // For std::basic_string
+#include <utility>      // For std::pair, std::move, std::swap
+#include <vector>       // For std::vector
+
+
+namespace StringPool
+{
+
+namespace Detail
+{
+
+//----------------------------------------------------------------------------------------
+// FSST-style symbol table, compressing and decompressing byte sequences.
+//----------------------------------------------------------------------------------------
+class SymbolTable
+{
+public:
+    enum
+    {
+        kMaxSymbols = 255,          // Codes 0-254 are symbols
+        kEscape = 255,              // Code followed by a literal byte
+        kMaxSymbolLength = 8,
+        kGenerations = 5,           // Training iterations
+
+        // Byte literals are counted as pseudo-codes during training
+        kCodeCount = 256 + kMaxSymbols
+    };
+
+    // STL-style non-throwing swap
+    friend void swap(SymbolTable& a, SymbolTable& b) noexcept
+    {
+        using std::swap;
+        swap(a.m_symbols,     b.m_symbols);
+        swap(a.m_byFirstByte, b.m_byFirstByte);
+        swap(a.m_masks,       b.m_masks);
+    }
+
+    // Number of symbols in the table (0 before training).
+    size_t SymbolCount() const noexcept
+    {
+        return m_symbols.size();
+    }
+
+    // Train the table on a sample, made by the byte strings [text + begins[i],
+    // text + begins[i + 1]) (begins has one more item than the sample strings).
+    void Train(const uint8_t* text, const std::vector<size_t>& begins)
+    {
+        m_symbols.clear();
+        BuildIndex();
+
+        std::vector<uint32_t> counts1(kCodeCount);
+        std::vector<uint32_t> counts2(kCodeCount * kCodeCount);
+
+        for (int generation = 0; generation < kGenerations; ++generation)
+        {
+            std::fill(counts1.begin(), counts1.end(), 0);
+            std::fill(counts2.begin(), counts2.end(), 0);
+
+            // Count the symbols emitted compressing the sample with the current table,
+            // and the pairs of consecutive symbols
+            for (size_t i = 0; i + 1 < begins.size(); ++i)
+            {
+                const uint8_t* p = text + begins[i];
+                const uint8_t* end = text + begins[i + 1];
+                size_t previous = kCodeCount;
+                while (p < end)
+                {
+                    const size_t code = CodeOf(p, end - p);
+                    ++counts1[code];
+                    if (SymbolLength(code) > 1)
+                    {
+                        // Let single bytes compete with the longer symbols
+                        ++counts1[*p];
+                    }
+                    if (previous != kCodeCount)
+                    {
+                        ++counts2[previous * kCodeCount + code];
+                    }
+                    previous = code;
+                    p += SymbolLength(code);
+                }
+            }
+
+            // Candidates: the emitted symbols, and the concatenations of pairs,
+            // ranked by the number of bytes they cover
+            std::map<std::pair<uint64_t, size_t>, uint64_t> gains;
+            for (size_t code1 = 0; code1 < kCodeCount; ++code1)
+            {
+                if (counts1[code1] == 0)
+                {
+                    continue;
+                }
+
+                const size_t length1 = SymbolLength(code1);
+                gains[std::make_pair(SymbolValue(code1), length1)] +=
+                    static_cast<uint64_t>(counts1[code1]) * length1;
+
+                for (size_t code2 = 0; code2 < kCodeCount; ++code2)
+                {
+                    const uint32_t count = counts2[code1 * kCodeCount + code2];
+                    if (count == 0)
+                    {
+                        continue;
+                    }
+
+                    const size_t length2 = SymbolLength(code2);
+                    if (length1 + length2 > kMaxSymbolLength)
+                    {
+                        continue;
+                    }
+
+                    uint8_t bytes[2 * kMaxSymbolLength];
+                    const uint64_t value1 = SymbolValue(code1);
+                    const uint64_t value2 = SymbolValue(code2);
+                    memcpy(bytes, &value1, kMaxSymbolLength);
+                    memcpy(bytes + length1, &value2, kMaxSymbolLength);
+
+                    uint64_t value = 0;
+                    memcpy(&value, bytes, length1 + length2);
+                    gains[std::make_pair(value, length1 + length2)] +=
+                        static_cast<uint64_t>(count) * (length1 + length2);
+                }
+            }
+
+            std::vector<std::pair<uint64_t, std::pair<uint64_t, size_t>>> ranked;
+            ranked.reserve(gains.size());
+            for (const auto& candidate : gains)
+            {
+                ranked.push_back(std::make_pair(candidate.second, candidate.first));
+            }
+            std::sort(ranked.begin(), ranked.end(),
+                [](const std::pair<uint64_t, std::pair<uint64_t, size_t>>& a,
+                   const std::pair<uint64_t, std::pair<uint64_t, size_t>>& b)
+                {
+                    return a.first > b.first;
+                });
+
+            m_symbols.clear();
+            for (size_t i = 0; i < ranked.size() && m_symbols.size() < kMaxSymbols; ++i)
+            {
+                m_symbols.push_back(Symbol{ ranked[i].second.first,
+                                            static_cast<uint8_t>(ranked[i].second.second) });
+            }
+            BuildIndex();
+        }
+    }
+
+    // Upper bound of the compressed size of 'size' bytes (all escaped).
+    static size_t MaxCompressedSize(size_t size) noexcept
+    {
+        return 2 * size;
+    }
+
+    // Compress the 'size' bytes of 'source' into 'dest'
+    // (with room for MaxCompressedSize bytes), returning the compressed size.
+    size_t Compress(const uint8_t* source, size_t size, uint8_t* dest) const noexcept
+    {
+        const uint8_t* p = source;
+        const uint8_t* end = source + size;
+        uint8_t* out = dest;
+        while (p < end)
+        {
+            const size_t code = CodeOf(p, end - p);
+            if (code >= 256)
+            {
+                *out++ = static_cast<uint8_t>(code - 256);
+                p += m_symbols[code - 256].Length;
+            }
+            else
+            {
+                *out++ = kEscape;
+                *out++ = *p++;
+            }
+        }
+        return out - dest;
+    }
+
+    // Decompress the 'size' code bytes into 'dest', that must have room for
+    // the 'capacity' bytes of the decompressed string.
+    void Decompress(const uint8_t* codes, size_t size,
+                    uint8_t* dest, size_t capacity) const noexcept
+    {
+        const uint8_t* end = codes + size;
+        uint8_t* out = dest;
+
+        // Fast path: copy 8 bytes per symbol, while there's room for them
+        uint8_t* const fastEnd = (capacity >= kMaxSymbolLength) ?
+            dest + capacity - kMaxSymbolLength : dest;
+        while (codes < end && out <= fastEnd)
+        {
+            const uint8_t code = *codes++;
+            if (code != kEscape)
+            {
+                memcpy(out, &m_symbols[code].Value, kMaxSymbolLength);
+                out += m_symbols[code].Length;
+            }
+            else
+            {
+                *out++ = *codes++;
+            }
+        }
+
+        // Tail: copy the exact symbol lengths
+        while (codes < end)
+        {
+            const uint8_t code = *codes++;
+            if (code != kEscape)
+            {
+                memcpy(out, &m_symbols[code].Value, m_symbols[code].Length);
+                out += m_symbols[code].Length;
+            }
+            else
+            {
+                *out++ = *codes++;
+            }
+        }
+    }
+
+private:
+    struct Symbol
+    {
+        uint64_t Value;     // The symbol bytes, followed by zeros
+        uint8_t Length;
+    };
+
+    std::vector<Symbol> m_symbols;
+
+    // For each first byte, the symbols starting with it, longest first
+    std::vector<uint8_t> m_byFirstByte[256];
+
+    // Masks selecting the first n bytes of a 64-bit value (in memory order)
+    uint64_t m_masks[kMaxSymbolLength + 1]{};
+
+    void BuildIndex()
+    {
+        for (auto& codes : m_byFirstByte)
+        {
+            codes.clear();
+        }
+
+        for (size_t code = 0; code < m_symbols.size(); ++code)
+        {
+            uint8_t firstByte;
+            memcpy(&firstByte, &m_symbols[code].Value, 1);
+            m_byFirstByte[firstByte].push_back(static_cast<uint8_t>(code));
+        }
+
+        for (auto& codes : m_byFirstByte)
+        {
+            std::sort(codes.begin(), codes.end(), [this](uint8_t a, uint8_t b)
+            {
+                return m_symbols[a].Length > m_symbols[b].Length;
+            });
+        }
+
+        for (size_t length = 0; length <= kMaxSymbolLength; ++length)
+        {
+            m_masks[length] = 0;
+            memset(&m_masks[length], 0xFF, length);
+        }
+    }
+
+    // Pseudo-code of the longest symbol matching the start of p[0, size)
+    // (256 + symbol code), or of its first byte literal (the byte value).
+    size_t CodeOf(const uint8_t* p, size_t size) const noexcept
+    {
+        uint64_t word = 0;
+        memcpy(&word, p, (std::min)(size, static_cast<size_t>(kMaxSymbolLength)));
+
+        for (const uint8_t code : m_byFirstByte[*p])
+        {
+            const Symbol& symbol = m_symbols[code];
+            if (symbol.Length <= size && (word & m_masks[symbol.Length]) == symbol.Value)
+            {
+                return 256 + code;
+            }
+        }
+        return *p;
+    }
+
+    uint64_t SymbolValue(size_t code) const noexcept
+    {
+        if (code >= 256)
+        {
+            return m_symbols[code - 256].Value;
+        }
+
+        uint64_t value = 0;
+        const uint8_t byte = static_cast<uint8_t>(code);
+        memcpy(&value, &byte, 1);
+        return value;
+    }
+
+    size_t SymbolLength(size_t code) const noexcept
+    {
+        return (code >= 256) ? m_symbols[code - 256].Length : 1;
+    }
+};
+
+} // namespace Detail
+
+
+//----------------------------------------------------------------------------------------
+// String compressed in a StringPool::BasicCompressedPool: the codes of the string
+// in the pool memory, their size, and the (decompressed) string length.
+//
+// Like String, copying this class is cheap, and its memory is managed by the pool.
+//----------------------------------------------------------------------------------------
+template <typename CharT>
+class BasicCompressedString
+{
+public:
+
+    // Creates an empty string.
+    BasicCompressedString() noexcept = default;
+
+    // Number of characters in the decompressed string.
+    size_t Length() const noexcept
+    {
+        return m_length;
+    }
+
+    bool IsEmpty() const noexcept
+    {
+        return m_length == 0;
+    }
+
+    // Size of the compressed string, in bytes.
+    size_t CompressedSize() const noexcept
+    {
+        return m_size;
+    }
+
+    // Check if this is equal to other, in the compressed domain.
+    // Both strings must come from the same pool (or pools with the same symbol table).
+    bool Equals(const BasicCompressedString& other) const noexcept
+    {
+        return m_length == other.m_length && m_size == other.m_size
+            && (m_size == 0 || memcmp(m_codes, other.m_codes, m_size) == 0);
+    }
+
+    // StringPool::BasicCompressedPool creates instances of this string class.
+    template <typename C> friend class BasicCompressedPool;
+
+private:
+    const uint8_t* m_codes{};   // The compressed string in the pool
+    uint32_t m_size{};          // Size of the codes, in bytes
+    uint32_t m_length{};        // Decompressed length, in characters
+
+    BasicCompressedString(const uint8_t* codes, uint32_t size, uint32_t length) noexcept
+        : m_codes{ codes }
+        , m_size{ size }
+        , m_length{ length }
+    {}
+};
+
+template <typename CharT>
+inline bool operator==(const BasicCompressedString<CharT>& a,
+                       const BasicCompressedString<CharT>& b) noexcept
+{
+    return a.Equals(b);
+}
+
+template <typename CharT>
+inline bool operator!=(const BasicCompressedString<CharT>& a,
+                       const BasicCompressedString<CharT>& b) noexcept
+{
+    return !a.Equals(b);
+}
+
+
+//----------------------------------------------------------------------------------------
+// String pool storing compressed strings.
+//
+// Train the symbol table on a sample of the strings first (strings allocated before
+// training are stored with escape codes only, taking twice their size).
+// The symbol table compresses the bytes of the characters, so it works for any
+// character type (e.g. an 8-byte symbol spans two wchar_t characters on Linux).
+//
+// Like the allocator, this class is not thread-safe; decompression is const,
+// and can run concurrently.
+//
+// StringPool::CompressedPool stores wchar_t strings.
+//----------------------------------------------------------------------------------------
+template <typename CharT>
+class BasicCompressedPool
+{
+public:
+
+    // The types of the strings of this pool
+    typedef BasicString<CharT> String;
+    typedef BasicCompressedString<CharT> CompressedString;
+
+    // Creates an empty pool, with an untrained symbol table.
+    BasicCompressedPool() = default;
+
+    // Ban copy, like the allocator
+    BasicCompressedPool(const BasicCompressedPool&) = delete;
+    BasicCompressedPool& operator=(const BasicCompressedPool&) = delete;
+
+    // Move the symbol table and the compressed strings from the other pool,
+    // leaving it empty and untrained, as if default-constructed.
+    // The compressed strings of the other pool remain valid, and are now owned
+    // by this pool.
+    BasicCompressedPool(BasicCompressedPool&& other) noexcept
+    {
+        swap(*this, other);
+    }
+
+    // Release the compressed strings of this pool, and move the symbol table and
+    // the compressed strings from the other pool, leaving it empty and untrained.
+    BasicCompressedPool& operator=(BasicCompressedPool&& other) noexcept
+    {
+        if (&other != this)
+        {
+            BasicCompressedPool temp{ std::move(other) };
+            swap(*this, temp);
+        }
+        return *this;
+    }
+
+    // STL-style non-throwing swap
+    friend void swap(BasicCompressedPool& a, BasicCompressedPool& b) noexcept
+    {
+        using std::swap;
+        swap(a.m_table,     b.m_table);
+        swap(a.m_allocator, b.m_allocator);
+        swap(a.m_buffer,    b.m_buffer);
+    }
+
+    // Train the symbol table on a sample of 'count' strings.
+    // The pool must be empty: the strings already compressed would be decoded with
+    // the new table, so Clear the pool before retraining it.
+    // Throws std::logic_error if the pool holds strings, and std::bad_alloc
+    // on allocation failure (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    void Train(const String* sample, size_t count)
+    {
+        if (AllocatedBytes() != 0)
+        {
+#ifdef STRINGPOOL_NO_EXCEPTIONS
+            std::abort();
+#else
+            throw std::logic_error("StringPool: can't train a pool holding strings");
+#endif
+        }
+
+        // Take up to kSampleBytes from strings spread over the whole sample
+        std::vector<uint8_t> text;
+        std::vector<size_t> begins(1, 0);
+        const size_t step = (count > kSampleStrings) ? count / kSampleStrings : 1;
+        for (size_t i = 0; i < count && text.size() < kSampleBytes; i += step)
+        {
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(sample[i].Str());
+            text.insert(text.end(), bytes, bytes + sample[i].Length() * sizeof(CharT));
+            begins.push_back(text.size());
+        }
+
+        m_table.Train(text.data(), begins);
+    }
+
+    void Train(const std::vector<String>& sample)
+    {
+        Train(sample.data(), sample.size());
+    }
+
+    // Number of symbols in the trained table.
+    size_t SymbolCount() const noexcept
+    {
+        return m_table.SymbolCount();
+    }
+
+    // Compress the [start, finish) string into the pool.
+    // Throws std::bad_alloc on allocation failure
+    // (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    CompressedString AllocString(const CharT* start, const CharT* finish)
+    {
+        const size_t length = finish - start;
+        if (length > kMaxStringLength)
+        {
+#ifdef STRINGPOOL_NO_EXCEPTIONS
+            std::abort();
+#else
+            throw std::bad_alloc();
+#endif
+        }
+
+        const size_t sizeInBytes = length * sizeof(CharT);
+        m_buffer.resize(Detail::SymbolTable::MaxCompressedSize(sizeInBytes));
+        const size_t compressedSize = m_table.Compress(
+            reinterpret_cast<const uint8_t*>(start), sizeInBytes, m_buffer.data());
+
+        uint8_t* codes = nullptr;
+        if (compressedSize != 0)
+        {
+            codes = static_cast<uint8_t*>(m_allocator.AllocBytes(compressedSize, 1));
+            memcpy(codes, m_buffer.data(), compressedSize);
+        }
+
+        return CompressedString{ codes, static_cast<uint32_t>(compressedSize),
+                                 static_cast<uint32_t>(length) };
+    }
+
+    CompressedString AllocString(const CharT* ptr)
+    {
+        return AllocString(ptr, ptr + std::char_traits<CharT>::length(ptr));
+    }
+
+    CompressedString AllocString(const String& s)
+    {
+        return AllocString(s.Str(), s.Str() + s.Length());
+    }
+
+    // Decompress a string of this pool into 'buffer', with room for s.Length() + 1
+    // characters (the string is NUL-terminated).
+    void Decompress(const CompressedString& s, CharT* buffer) const noexcept
+    {
+        m_table.Decompress(s.m_codes, s.m_size, reinterpret_cast<uint8_t*>(buffer),
+                           s.m_length * sizeof(CharT));
+        buffer[s.m_length] = CharT();
+    }
+
+    // Decompress a string of this pool into 'out'.
+    // Reusing 'out' in a loop avoids a memory allocation per string.
+    void Decompress(const CompressedString& s, std::basic_string<CharT>& out) const
+    {
+        out.resize(s.m_length);
+        if (s.m_length != 0)
+        {
+            m_table.Decompress(s.m_codes, s.m_size, reinterpret_cast<uint8_t*>(&out[0]),
+                               s.m_length * sizeof(CharT));
+        }
+    }
+
+    std::basic_string<CharT> Decompress(const CompressedString& s) const
+    {
+        std::basic_string<CharT> out;
+        Decompress(s, out);
+        return out;
+    }
+
+    // Total bytes of the chunks holding the compressed strings.
+    size_t AllocatedBytes() const noexcept
+    {
+        return m_allocator.AllocatedBytes();
+    }
+
+    // Release all the compressed strings (the symbol table is preserved).
+    void Clear()
+    {
+        m_allocator.Clear();
+    }
+
+
+private:
+    enum
+    {
+        // Training sample limits
+        kSampleBytes = 64 * 1024,
+        kSampleStrings = 4096,
+
+        // Can't compress strings larger than that (in characters)
+        kMaxStringLength = 1024 * 1024
+    };
+
+    Detail::SymbolTable m_table{};
+    BasicAllocator<char> m_allocator{};     // Holds the code bytes
+    std::vector<uint8_t> m_buffer{};        // Compression buffer
+};
+
+// Compressed pool of wchar_t strings, and its strings.
+using CompressedPool = BasicCompressedPool<wchar_t>;
+using CompressedString = BasicCompressedString<wchar_t>;
+
+} // namespace StringPool
+
+
+#endif // INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_COMPRESSION_H
@@ -0,0 +1,467 @@
+#ifndef INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_DICTIONARY_H
+#define INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_DICTIONARY_H
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//
+// Immutable, front-coded dictionary of sorted strings
+// (StringPool::FrontCodedDictionary), built from a sorted vector of pool-allocated
+// strings, to keep them for lookups in a fraction of the memory.
+//
+// The strings are stored in blocks: the first string of each block (the restart point)
+// is stored as it is, and each following string only stores the length of the prefix
+// it shares with the previous one, and the remaining suffix.
+// Lookups binary-search the block heads, then scan a single block.
+//
+// Copyright (C) by Giovanni Dicanio
+//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "StringPool.h"
+
+#include <cstddef>      // For size_t
+#include <string>       // For std::basic_string, std::char_traits
+#include <type_traits>  // For std::make_unsigned
+#include <vector>       // For std::vector
+
+
+namespace StringPool
+{
+
+namespace Detail
+{
+
+//
+// Lengths are stored in the character array as variable-length integers,
+// with the payload in the low bits of each character, and the high bit set
+// when more characters follow (e.g. 7 bits per char, 15 bits per char16_t).
+//
+
+template <typename CharT>
+inline void EncodeFrontCodedLength(size_t value, std::vector<CharT>& out)
+{
+    typedef typename std::make_unsigned<CharT>::type Unit;
+    const unsigned int kPayloadBits = (8 * sizeof(CharT)) - 1;
+    const Unit kMore = static_cast<Unit>(Unit(1) << kPayloadBits);
+
+    while (value >= kMore)
+    {
+        out.push_back(static_cast<CharT>(static_cast<Unit>(value & (kMore - 1)) | kMore));
+        value >>= kPayloadBits;
+    }
+    out.push_back(static_cast<CharT>(static_cast<Unit>(value)));
+}
+
+// Decode a length, advancing p past it.
+template <typename CharT>
+inline size_t DecodeFrontCodedLength(const CharT*& p) noexcept
+{
+    typedef typename std::make_unsigned<CharT>::type Unit;
+    const unsigned int kPayloadBits = (8 * sizeof(CharT)) - 1;
+    const Unit kMore = static_cast<Unit>(Unit(1) << kPayloadBits);
+
+    size_t value = 0;
+    unsigned int shift = 0;
+    for (;;)
+    {
+        const Unit unit = static_cast<Unit>(*p++);
+        value |= static_cast<size_t>(unit & (kMore - 1)) << shift;
+        if ((unit & kMore) == 0)
+        {
+            return value;
+        }
+        shift += kPayloadBits;
+    }
+}
+
+// Compare a[0, lengthA) with b[0, lengthB), like BasicString::Compare.
+template <typename CharT>
+inline int CompareRanges(const CharT* a, size_t lengthA,
+                         const CharT* b, size_t lengthB) noexcept
+{
+    const size_t minLength = lengthA < lengthB ? lengthA : lengthB;
+
+    const int result = CompareChars(a, b, minLength);
+    if (result != 0)
+        return result;
+
+    if (lengthA < lengthB)
+        return -1;
+
+    if (lengthA > lengthB)
+        return 1;
+
+    return 0;
+}
+
+} // namespace Detail
+
+
+//----------------------------------------------------------------------------------------
+// Immutable front-coded dictionary of sorted, distinct strings.
+//
+// Each string is identified by its ID, i.e. its index in sorted order, and:
+// - Find and Rank binary-search a key (Rank returns the ID of the first string
+//   not less than the key, so it's also the number of strings less than the key);
+// - Select rebuilds the string with a given ID;
+// - ForEachWithPrefix enumerates the strings starting with a prefix, in order.
+//
+// The strings are compared like BasicString::Compare (std::char_traits order).
+// The dictionary owns its memory, and doesn't refer to the source pool,
+// that can be released after building it.
+//
+// StringPool::FrontCodedDictionary stores wchar_t strings.
+//----------------------------------------------------------------------------------------
+template <typename CharT>
+class BasicFrontCodedDictionary
+{
+public:
+
+    // The types of the dictionary strings
+    typedef BasicString<CharT> String;
+    typedef std::basic_string<CharT> StdString;
+
+    // Returned by Find for missing keys
+    static const size_t kNotFound = static_cast<size_t>(-1);
+
+    // Default number of strings in each block: larger blocks take less memory,
+    // smaller blocks make lookups faster.
+    static const size_t kDefaultBlockSize = 16;
+
+    // Creates an empty dictionary.
+    BasicFrontCodedDictionary() = default;
+
+    // Build the dictionary from the 'count' strings, that must be sorted
+    // (e.g. with StringPool::Sort); duplicates are stored only once.
+    // Throws std::bad_alloc on allocation failure.
+    BasicFrontCodedDictionary(const String* sorted, size_t count,
+                              size_t blockSize = kDefaultBlockSize)
+    {
+        Build(sorted, count, blockSize);
+    }
+
+    explicit BasicFrontCodedDictionary(const std::vector<String>& sorted,
+                                       size_t blockSize = kDefaultBlockSize)
+    {
+        Build(sorted.data(), sorted.size(), blockSize);
+    }
+
+    // Number of (distinct) strings in the dictionary.
+    size_t Size() const noexcept
+    {
+        return m_count;
+    }
+
+    bool IsEmpty() const noexcept
+    {
+        return m_count == 0;
+    }
+
+    // Memory used by the dictionary, in bytes.
+    size_t MemoryBytes() const noexcept
+    {
+        return (m_data.capacity() * sizeof(CharT))
+            + (m_blockOffsets.capacity() * sizeof(size_t));
+    }
+
+    // ID of the first string not less than the key
+    // (Size() if all the strings are less than the key).
+    size_t Rank(const CharT* key, size_t length) const noexcept
+    {
+        bool found;
+        return LowerBound(key, length, found);
+    }
+
+    size_t Rank(const String& key) const noexcept
+    {
+        return Rank(key.Str(), key.Length());
+    }
+
+    // ID of the string equal to the key, or kNotFound if the key is missing.
+    size_t Find(const CharT* key, size_t length) const noexcept
+    {
+        bool found;
+        const size_t id = LowerBound(key, length, found);
+        return found ? id : kNotFound;
+    }
+
+    size_t Find(const String& key) const noexcept
+    {
+        return Find(key.Str(), key.Length());
+    }
+
+    // Rebuild the string with the given ID (id < Size()) into 'out'.
+    // Reusing 'out' in a loop avoids a memory allocation per string.
+    void Select(size_t id, StdString& out) const
+    {
+        SeekTo(id, out);
+    }
+
+    StdString Select(size_t id) const
+    {
+        StdString out;
+        SeekTo(id, out);
+        return out;
+    }
+
+    // Invoke func(id, s) for each string s starting with the given prefix, in order.
+    // 's' is a const StdString&, reused for all the strings.
+    template <typename Func>
+    void ForEachWithPrefix(const CharT* prefix, size_t length, Func func) const
+    {
+        size_t id = Rank(prefix, length);
+        if (id >= m_count)
+        {
+            return;
+        }
+
+        StdString s;
+        const CharT* p = SeekTo(id, s);
+        if (!StartsWith(s, prefix, length))
+        {
+            return;
+        }
+
+        for (;;)
+        {
+            func(id, static_cast<const StdString&>(s));
+
+            if (++id == m_count)
+            {
+                return;
+            }
+
+            if (id % m_blockSize == 0)
+            {
+                // Restart point: the head is stored as it is
+                const size_t headLength = Detail::DecodeFrontCodedLength(p);
+                s.assign(p, headLength);
+                p += headLength;
+
+                if (!StartsWith(s, prefix, length))
+                {
+                    return;
+                }
+            }
+            else
+            {
+                // The strings are sorted: the first one sharing less than the prefix
+                // with the previous one (that starts with the prefix) doesn't
+                const size_t lcp = Detail::DecodeFrontCodedLength(p);
+                if (lcp < length)
+                {
+                    return;
+                }
+
+                const size_t suffixLength = Detail::DecodeFrontCodedLength(p);
+                s.resize(lcp);
+                s.append(p, suffixLength);
+                p += suffixLength;
+            }
+        }
+    }
+
+    template <typename Func>
+    void ForEachWithPrefix(const String& prefix, Func func) const
+    {
+        ForEachWithPrefix(prefix.Str(), prefix.Length(), func);
+    }
+
+
+private:
+    std::vector<CharT> m_data{};            // The encoded blocks
+    std::vector<size_t> m_blockOffsets{};   // Start of each block in m_data
+    size_t m_count{};
+    size_t m_blockSize{ kDefaultBlockSize };
+
+    void Build(const String* sorted, size_t count, size_t blockSize)
+    {
+        m_blockSize = (blockSize != 0) ? blockSize : 1;
+
+        const String* previous = nullptr;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const String& s = sorted[i];
+
+            size_t lcp = 0;
+            if (previous != nullptr)
+            {
+                const size_t minLength = previous->Length() < s.Length() ?
+                    previous->Length() : s.Length();
+                lcp = Detail::Mismatch(previous->Str(), s.Str(), minLength);
+
+                // Skip duplicates
+                if (lcp == previous->Length() && lcp == s.Length())
+                {
+                    continue;
+                }
+            }
+
+            if (m_count % m_blockSize == 0)
+            {
+                m_blockOffsets.push_back(m_data.size());
+                lcp = 0;
+            }
+            else
+            {
+                Detail::EncodeFrontCodedLength(lcp, m_data);
+            }
+
+            Detail::EncodeFrontCodedLength(s.Length() - lcp, m_data);
+            m_data.insert(m_data.end(), s.Str() + lcp, s.Str() + s.Length());
+
+            previous = &s;
+            ++m_count;
+        }
+
+        m_data.shrink_to_fit();
+        m_blockOffsets.shrink_to_fit();
+    }
+
+    // Rebuild the string with the given ID into 'out',
+    // and return the position of the following string.
+    const CharT* SeekTo(size_t id, StdString& out) const
+    {
+        const size_t block = id / m_blockSize;
+        const CharT* p = m_data.data() + m_blockOffsets[block];
+
+        const size_t headLength = Detail::DecodeFrontCodedLength(p);
+        out.assign(p, headLength);
+        p += headLength;
+
+        for (size_t i = block * m_blockSize; i < id; ++i)
+        {
+            const size_t lcp = Detail::DecodeFrontCodedLength(p);
+            const size_t suffixLength = Detail::DecodeFrontCodedLength(p);
+            out.resize(lcp);
+            out.append(p, suffixLength);
+            p += suffixLength;
+        }
+
+        return p;
+    }
+
+    static bool StartsWith(const StdString& s, const CharT* prefix, size_t length) noexcept
+    {
+        return s.size() >= length
+            && Detail::Mismatch(s.data(), prefix, length) == length;
+    }
+
+    // ID of the first string not less than the key; 'found' is set to true
+    // if that string is equal to the key.
+    size_t LowerBound(const CharT* key, size_t length, bool& found) const noexcept
+    {
+        found = false;
+
+        // Find the first block whose head is greater than the key
+        size_t low = 0;
+        size_t high = m_blockOffsets.size();
+        while (low < high)
+        {
+            const size_t middle = low + (high - low) / 2;
+            const CharT* p = m_data.data() + m_blockOffsets[middle];
+            const size_t headLength = Detail::DecodeFrontCodedLength(p);
+
+            const int result = Detail::CompareRanges(p, headLength, key, length);
+            if (result == 0)
+            {
+                found = true;
+                return middle * m_blockSize;
+            }
+
+            if (result < 0)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+
+        if (low == 0)
+        {
+            return 0;
+        }
+
+        // Scan the previous block, whose head is less than the key.
+        // 'match' is the length of the prefix shared by the current string and the key:
+        // no characters need to be rebuilt, as each string only has to be compared
+        // with the key past the prefix shared with the previous string.
+        const size_t block = low - 1;
+        const CharT* p = m_data.data() + m_blockOffsets[block];
+        const size_t headLength = Detail::DecodeFrontCodedLength(p);
+        size_t match = Detail::Mismatch(p, key, headLength < length ? headLength : length);
+        p += headLength;
+
+        size_t id = block * m_blockSize;
+        const size_t last = (m_count - id < m_blockSize) ? m_count : id + m_blockSize;
+        for (++id; id < last; ++id)
+        {
+            const size_t lcp = Detail::DecodeFrontCodedLength(p);
+            const size_t suffixLength = Detail::DecodeFrontCodedLength(p);
+            const CharT* suffix = p;
+            p += suffixLength;
+
+            // The previous string is less than the key, and differs from it at 'match':
+            // this string has the same character there, so it's less too
+            if (lcp > match)
+            {
+                continue;
+            }
+
+            // This string is greater than the previous one at 'lcp', where the previous
+            // one matches the key: it's greater than the key
+            if (lcp < match)
+            {
+                return id;
+            }
+
+            // Compare the suffix with the rest of the key
+            const size_t keyRest = length - match;
+            const size_t minLength = suffixLength < keyRest ? suffixLength : keyRest;
+            const size_t mismatch = Detail::Mismatch(suffix, key + match, minLength);
+
+            if (mismatch < minLength)
+            {
+                if (std::char_traits<CharT>::lt(suffix[mismatch], key[match + mismatch]))
+                {
+                    match += mismatch;
+                    continue;
+                }
+                return id;
+            }
+
+            if (suffixLength == keyRest)
+            {
+                found = true;
+                return id;
+            }
+
+            if (suffixLength > keyRest)
+            {
+                // The key is a prefix of this string
+                return id;
+            }
+
+            // This string is a prefix of the key
+            match += suffixLength;
+        }
+
+        return last;
+    }
+};
+
+template <typename CharT>
+const size_t BasicFrontCodedDictionary<CharT>::kNotFound;
+
+template <typename CharT>
+const size_t BasicFrontCodedDictionary<CharT>::kDefaultBlockSize;
+
+// Front-coded dictionary of wchar_t strings.
+using FrontCodedDictionary = BasicFrontCodedDictionary<wchar_t>;
+
+} // namespace StringPool
+
+
+#endif // INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_DICTIONARY_H
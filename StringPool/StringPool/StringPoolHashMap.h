@@ -0,0 +1,579 @@
+#ifndef INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_HASHMAP_H
+#define INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_HASHMAP_H
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//
+// Open-addressing hash map keyed by pooled strings (StringPool::StringHashMap),
+// in the style of the "Swiss tables".
+//
+// The keys (String handles) and the values are stored inline in a flat slot array,
+// so there's no allocation per element.
+// A parallel array of control bytes holds 7 bits of the hash of each key
+// (or marks the slot as empty or deleted): lookups compare 16 control bytes at a time
+// with SSE2, and only touch the slots, and the pool memory of their key strings,
+// for the candidate matches.
+//
+// Copyright (C) by Giovanni Dicanio
+//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "StringPool.h"
+
+#include <cstddef>      // For size_t
+#include <cstdint>      // For uint8_t, int8_t, uint32_t, uint64_t
+#include <cstring>      // For memcpy, memset
+#include <memory>       // For std::allocator, std::unique_ptr
+#include <new>          // For placement new
+#include <string>       // For std::char_traits
+#include <utility>      // For std::pair, std::move, std::swap
+
+
+namespace StringPool
+{
+
+namespace Detail
+{
+
+// Final mix of a 64-bit hash (from MurmurHash3), spreading all the input bits
+// to all the output bits.
+inline uint64_t MixHash(uint64_t h) noexcept
+{
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Hash of the bytes of s[0, length), processing 8 bytes at a time.
+template <typename CharT>
+inline uint64_t HashChars(const CharT* s, size_t length) noexcept
+{
+    const uint64_t kMultiplier = 0x9E3779B97F4A7C15ULL;
+
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(s);
+    size_t size = length * sizeof(CharT);
+    uint64_t h = size * kMultiplier;
+
+    for (; size >= 8; size -= 8, p += 8)
+    {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        h = (h ^ word) * kMultiplier;
+        h ^= h >> 32;
+    }
+
+    if (size != 0)
+    {
+        uint64_t word = 0;
+        memcpy(&word, p, size);
+        h = (h ^ word) * kMultiplier;
+    }
+
+    return MixHash(h);
+}
+
+} // namespace Detail
+
+
+// Hash functor for pooled strings, e.g. for std::unordered_map.
+struct StringHash
+{
+    template <typename CharT>
+    size_t operator()(const BasicString<CharT>& s) const noexcept
+    {
+        return static_cast<size_t>(Detail::HashChars(s.Str(), s.Length()));
+    }
+};
+
+
+//----------------------------------------------------------------------------------------
+// Hash map from pooled strings to values.
+//
+// The map stores the String handles, not copies of the strings: the pool allocator
+// of the keys must outlive the map.
+// Pointers to the values are invalidated when the map grows (like the iterators
+// of std::vector).
+//
+// StringPool::StringHashMap<ValueT> maps wchar_t strings.
+//----------------------------------------------------------------------------------------
+template <typename CharT, typename ValueT>
+class BasicStringHashMap
+{
+public:
+    typedef BasicString<CharT> String;
+
+    // Creates an empty map; no memory is allocated until the first insertion.
+    BasicStringHashMap() noexcept = default;
+
+    // Creates an empty map with room for 'count' elements.
+    // Throws std::bad_alloc on allocation failure.
+    explicit BasicStringHashMap(size_t count)
+    {
+        Reserve(count);
+    }
+
+    ~BasicStringHashMap()
+    {
+        Release();
+    }
+
+    // Ban copy, like the allocator
+    BasicStringHashMap(const BasicStringHashMap&) = delete;
+    BasicStringHashMap& operator=(const BasicStringHashMap&) = delete;
+
+    BasicStringHashMap(BasicStringHashMap&& other) noexcept
+    {
+        swap(*this, other);
+    }
+
+    BasicStringHashMap& operator=(BasicStringHashMap&& other) noexcept
+    {
+        BasicStringHashMap temp{ std::move(other) };
+        swap(*this, temp);
+        return *this;
+    }
+
+    friend void swap(BasicStringHashMap& a, BasicStringHashMap& b) noexcept
+    {
+        using std::swap;
+        swap(a.m_control, b.m_control);
+        swap(a.m_slots, b.m_slots);
+        swap(a.m_capacity, b.m_capacity);
+        swap(a.m_size, b.m_size);
+        swap(a.m_deleted, b.m_deleted);
+    }
+
+    // Number of elements in the map.
+    size_t Size() const noexcept
+    {
+        return m_size;
+    }
+
+    bool IsEmpty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    // Number of slots (a power of 2, or 0 before the first insertion).
+    size_t Capacity() const noexcept
+    {
+        return m_capacity;
+    }
+
+    // Make room for 'count' elements, without growing.
+    // Throws std::bad_alloc on allocation failure
+    // (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    void Reserve(size_t count)
+    {
+        size_t capacity = kGroupWidth;
+        while (MaxLoad(capacity) < count)
+        {
+            // The capacity would overflow: no room for that many slots anyway
+            if (capacity > static_cast<size_t>(-1) / 2)
+            {
+#ifdef STRINGPOOL_NO_EXCEPTIONS
+                std::abort();
+#else
+                throw std::bad_alloc();
+#endif
+            }
+
+            capacity *= 2;
+        }
+
+        if (capacity > m_capacity)
+        {
+            Rehash(capacity);
+        }
+    }
+
+    // Add a key with its value, if the key is not in the map.
+    // Returns a pointer to the value in the map, and true if the key has been added
+    // (false if it was already there, and its value hasn't changed).
+    // Throws std::bad_alloc on allocation failure.
+    std::pair<ValueT*, bool> Insert(const String& key, const ValueT& value)
+    {
+        return Emplace(key, value);
+    }
+
+    std::pair<ValueT*, bool> Insert(const String& key, ValueT&& value)
+    {
+        return Emplace(key, std::move(value));
+    }
+
+    // Value of the key, adding the key with a default-constructed value if it's not
+    // in the map.
+    ValueT& operator[](const String& key)
+    {
+        return *Emplace(key).first;
+    }
+
+    // Look up the [start, finish) key (that doesn't need to be in a pool).
+    // Returns a pointer to its value, or nullptr if the key is not in the map.
+    ValueT* Find(const CharT* start, const CharT* finish) noexcept
+    {
+        const size_t length = finish - start;
+        const size_t index = FindIndex(start, length, Detail::HashChars(start, length));
+        return (index != kNotFound) ? &m_slots[index].Value : nullptr;
+    }
+
+    const ValueT* Find(const CharT* start, const CharT* finish) const noexcept
+    {
+        return const_cast<BasicStringHashMap*>(this)->Find(start, finish);
+    }
+
+    ValueT* Find(const String& key) noexcept
+    {
+        return Find(key.Str(), key.Str() + key.Length());
+    }
+
+    const ValueT* Find(const String& key) const noexcept
+    {
+        return Find(key.Str(), key.Str() + key.Length());
+    }
+
+    bool Contains(const String& key) const noexcept
+    {
+        return Find(key) != nullptr;
+    }
+
+    // Remove a key from the map; returns false if the key was not in the map.
+    bool Erase(const String& key) noexcept
+    {
+        const size_t index = FindIndex(key.Str(), key.Length(),
+                                       Detail::HashChars(key.Str(), key.Length()));
+        if (index == kNotFound)
+        {
+            return false;
+        }
+
+        // Leave a tombstone, so that the probe sequences passing here continue
+        m_slots[index].~Slot();
+        SetControl(index, kDeleted);
+        --m_size;
+        ++m_deleted;
+        return true;
+    }
+
+    // Remove all the elements (the slot memory is kept).
+    void Clear() noexcept
+    {
+        DestroySlots();
+        if (m_capacity != 0)
+        {
+            memset(m_control, kEmpty, m_capacity + kGroupWidth - 1);
+        }
+        m_size = 0;
+        m_deleted = 0;
+    }
+
+    // Call func(const String& key, ValueT& value) for all the elements
+    // (in no particular order).
+    template <typename Func>
+    void ForEach(Func func)
+    {
+        for (size_t i = 0; i < m_capacity; ++i)
+        {
+            if (IsFull(m_control[i]))
+            {
+                func(static_cast<const String&>(m_slots[i].Key), m_slots[i].Value);
+            }
+        }
+    }
+
+
+private:
+    struct Slot
+    {
+        String Key;
+        ValueT Value;
+    };
+
+    enum : int8_t
+    {
+        // Control bytes of the free slots; full slots hold 7 bits of the key hash
+        kEmpty = -128,
+        kDeleted = -2
+    };
+
+    enum : size_t
+    {
+        kGroupWidth = 16,
+        kNotFound = static_cast<size_t>(-1)
+    };
+
+    // Control bytes: one per slot, followed by a copy of the first kGroupWidth - 1,
+    // so that a group of kGroupWidth can be loaded starting at any slot
+    int8_t* m_control{};
+    Slot* m_slots{};
+    size_t m_capacity{};
+    size_t m_size{};
+    size_t m_deleted{};     // Tombstones
+
+
+    // Maximum load factor: 7/8.
+    static size_t MaxLoad(size_t capacity) noexcept
+    {
+        return capacity - capacity / 8;
+    }
+
+    static bool IsFull(int8_t control) noexcept
+    {
+        return control >= 0;
+    }
+
+    // The high hash bits select the first probed slot, the low 7 bits go
+    // in the control byte.
+    static size_t H1(uint64_t hash) noexcept
+    {
+        return static_cast<size_t>(hash >> 7);
+    }
+
+    static int8_t H2(uint64_t hash) noexcept
+    {
+        return static_cast<int8_t>(hash & 0x7F);
+    }
+
+    //
+    // Bit masks of the control bytes of the group starting at 'control'
+    // that match a hash fragment, or that are free (empty or deleted)
+    //
+
+#ifdef STRINGPOOL_HAS_SSE2
+
+    static uint32_t MatchGroup(const int8_t* control, int8_t h2) noexcept
+    {
+        const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(h2))));
+    }
+
+    static uint32_t MatchEmpty(const int8_t* control) noexcept
+    {
+        const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+        return static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(kEmpty))));
+    }
+
+    // The free slots have the sign bit set
+    static uint32_t MatchFree(const int8_t* control) noexcept
+    {
+        const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+        return static_cast<uint32_t>(_mm_movemask_epi8(group));
+    }
+
+    static unsigned int FirstMatch(uint32_t mask) noexcept
+    {
+        return Detail::LowestSetBit(mask);
+    }
+
+#else
+
+    static uint32_t MatchGroup(const int8_t* control, int8_t h2) noexcept
+    {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupWidth; ++i)
+        {
+            mask |= static_cast<uint32_t>(control[i] == h2) << i;
+        }
+        return mask;
+    }
+
+    static uint32_t MatchEmpty(const int8_t* control) noexcept
+    {
+        return MatchGroup(control, kEmpty);
+    }
+
+    static uint32_t MatchFree(const int8_t* control) noexcept
+    {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kGroupWidth; ++i)
+        {
+            mask |= static_cast<uint32_t>(control[i] < 0) << i;
+        }
+        return mask;
+    }
+
+    static unsigned int FirstMatch(uint32_t mask) noexcept
+    {
+        unsigned int index = 0;
+        while ((mask & 1) == 0)
+        {
+            mask >>= 1;
+            ++index;
+        }
+        return index;
+    }
+
+#endif // STRINGPOOL_HAS_SSE2
+
+    void SetControl(size_t index, int8_t control) noexcept
+    {
+        m_control[index] = control;
+        if (index < kGroupWidth - 1)
+        {
+            m_control[m_capacity + index] = control;
+        }
+    }
+
+    static bool KeyEquals(const String& key, const CharT* chars, size_t length) noexcept
+    {
+        return key.Length() == length
+            && (length == 0 || std::char_traits<CharT>::compare(key.Str(), chars, length) == 0);
+    }
+
+    // Index of the slot holding the key, or kNotFound.
+    // The probe sequence visits groups at triangular offsets, that cover all the groups
+    // of a power-of-2 capacity.
+    size_t FindIndex(const CharT* chars, size_t length, uint64_t hash) const noexcept
+    {
+        if (m_capacity == 0)
+        {
+            return kNotFound;
+        }
+
+        const size_t mask = m_capacity - 1;
+        const int8_t h2 = H2(hash);
+        size_t position = H1(hash) & mask;
+        size_t step = 0;
+        for (;;)
+        {
+            for (uint32_t matches = MatchGroup(m_control + position, h2); matches != 0;
+                 matches &= matches - 1)
+            {
+                const size_t index = (position + FirstMatch(matches)) & mask;
+                if (KeyEquals(m_slots[index].Key, chars, length))
+                {
+                    return index;
+                }
+            }
+
+            // An empty slot ends the probe sequence
+            if (MatchEmpty(m_control + position) != 0)
+            {
+                return kNotFound;
+            }
+
+            step += kGroupWidth;
+            position = (position + step) & mask;
+        }
+    }
+
+    // Index of the first free slot in the probe sequence of the hash.
+    size_t FindFreeIndex(uint64_t hash) const noexcept
+    {
+        const size_t mask = m_capacity - 1;
+        size_t position = H1(hash) & mask;
+        size_t step = 0;
+        for (;;)
+        {
+            const uint32_t free = MatchFree(m_control + position);
+            if (free != 0)
+            {
+                return (position + FirstMatch(free)) & mask;
+            }
+
+            step += kGroupWidth;
+            position = (position + step) & mask;
+        }
+    }
+
+    template <typename... Args>
+    std::pair<ValueT*, bool> Emplace(const String& key, Args&&... args)
+    {
+        const uint64_t hash = Detail::HashChars(key.Str(), key.Length());
+        const size_t found = FindIndex(key.Str(), key.Length(), hash);
+        if (found != kNotFound)
+        {
+            return std::make_pair(&m_slots[found].Value, false);
+        }
+
+        if (m_size + m_deleted + 1 > MaxLoad(m_capacity))
+        {
+            // Grow, or just purge the tombstones if they take most of the room
+            const size_t capacity = (m_capacity == 0) ? kGroupWidth
+                : (m_size + 1 > MaxLoad(m_capacity) / 2) ? m_capacity * 2 : m_capacity;
+            Rehash(capacity);
+        }
+
+        const size_t index = FindFreeIndex(hash);
+        new (&m_slots[index]) Slot{ key, ValueT(std::forward<Args>(args)...) };
+        if (m_control[index] == kDeleted)
+        {
+            --m_deleted;
+        }
+        SetControl(index, H2(hash));
+        ++m_size;
+        return std::make_pair(&m_slots[index].Value, true);
+    }
+
+    // Move the elements into new slot and control arrays.
+    void Rehash(size_t capacity)
+    {
+        std::unique_ptr<int8_t[]> control{ new int8_t[capacity + kGroupWidth - 1] };
+        memset(control.get(), kEmpty, capacity + kGroupWidth - 1);
+
+        std::allocator<Slot> slotAllocator;
+        Slot* slots = slotAllocator.allocate(capacity);
+
+        int8_t* oldControl = m_control;
+        Slot* oldSlots = m_slots;
+        const size_t oldCapacity = m_capacity;
+
+        m_control = control.release();
+        m_slots = slots;
+        m_capacity = capacity;
+        m_deleted = 0;
+
+        for (size_t i = 0; i < oldCapacity; ++i)
+        {
+            if (IsFull(oldControl[i]))
+            {
+                Slot& slot = oldSlots[i];
+                const uint64_t hash = Detail::HashChars(slot.Key.Str(), slot.Key.Length());
+                const size_t index = FindFreeIndex(hash);
+                new (&m_slots[index]) Slot{ slot.Key, std::move(slot.Value) };
+                SetControl(index, H2(hash));
+                slot.~Slot();
+            }
+        }
+
+        if (oldSlots != nullptr)
+        {
+            slotAllocator.deallocate(oldSlots, oldCapacity);
+        }
+        delete[] oldControl;
+    }
+
+    void DestroySlots() noexcept
+    {
+        for (size_t i = 0; i < m_capacity; ++i)
+        {
+            if (IsFull(m_control[i]))
+            {
+                m_slots[i].~Slot();
+            }
+        }
+    }
+
+    void Release() noexcept
+    {
+        DestroySlots();
+        if (m_slots != nullptr)
+        {
+            std::allocator<Slot>().deallocate(m_slots, m_capacity);
+        }
+        delete[] m_control;
+    }
+};
+
+// Hash map from wchar_t strings to values.
+template <typename ValueT>
+using StringHashMap = BasicStringHashMap<wchar_t, ValueT>;
+
+} // namespace StringPool
+
+
+#endif // INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_HASHMAP_H
@@ -0,0 +1,96 @@
+#ifndef INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_PMR_H
+#define INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_PMR_H
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//
+// std::pmr::memory_resource adapter for the string pool allocator
+// (StringPool::MemoryResource), to store other data (e.g. std::pmr::vector,
+// std::pmr::wstring) in the same chunks of the pooled strings.
+//
+// Requires C++17 and a standard library with <memory_resource>:
+// STRINGPOOL_HAS_PMR is defined when the adapter is available.
+//
+// Copyright (C) by Giovanni Dicanio
+//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "StringPool.h"
+
+#if (defined(_MSVC_LANG) ? _MSVC_LANG : __cplusplus) >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>  // For std::pmr::memory_resource
+#endif
+#endif
+
+#if defined(__cpp_lib_memory_resource)
+#define STRINGPOOL_HAS_PMR
+#endif
+
+
+#ifdef STRINGPOOL_HAS_PMR
+
+namespace StringPool
+{
+
+//----------------------------------------------------------------------------------------
+// Memory resource drawing memory from the chunks of a string pool allocator
+// (see BasicAllocator::AllocBytes), with monotonic semantics:
+// allocations are simple pointer increases, deallocations are no-ops, and the memory
+// is released all together by the allocator (Clear, or destructor).
+//
+// The allocator must outlive the memory resource, and the containers using it.
+// Like the allocator, this class is not thread-safe.
+//
+// StringPool::MemoryResource uses the default StringPool::Allocator.
+//----------------------------------------------------------------------------------------
+template <typename AllocatorType>
+class BasicMemoryResource : public std::pmr::memory_resource
+{
+public:
+
+    explicit BasicMemoryResource(AllocatorType& allocator) noexcept
+        : m_allocator{ allocator }
+    {}
+
+    // Ban copy, like std::pmr::monotonic_buffer_resource
+    BasicMemoryResource(const BasicMemoryResource&) = delete;
+    BasicMemoryResource& operator=(const BasicMemoryResource&) = delete;
+
+    // The string pool allocator owning the memory.
+    AllocatorType& GetAllocator() const noexcept
+    {
+        return m_allocator;
+    }
+
+
+private:
+    AllocatorType& m_allocator;
+
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        return m_allocator.AllocBytes(bytes, alignment);
+    }
+
+    void do_deallocate(void* /* ptr */, size_t /* bytes */, size_t /* alignment */) override
+    {
+        // Monotonic: the memory is released with the allocator chunks
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        // Resources on the same allocator can free each other's memory (with no-ops)
+        const auto* otherResource = dynamic_cast<const BasicMemoryResource*>(&other);
+        return otherResource != nullptr && &otherResource->m_allocator == &m_allocator;
+    }
+};
+
+// Memory resource using the default string pool allocator.
+using MemoryResource = BasicMemoryResource<Allocator>;
+
+} // namespace StringPool
+
+#endif // STRINGPOOL_HAS_PMR
+
+
+#endif // INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_PMR_H
@@ -0,0 +1,287 @@
+#ifndef INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_READER_H
+#define INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_READER_H
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//
+// Streaming line reader (StringPool::LineReader), loading the lines of text files
+// (e.g. word lists and logs) directly into a string pool.
+//
+// The file is read in large blocks, the line breaks are found with a SIMD scan,
+// and the lines are written straight into the pool chunks, with no intermediate
+// std::string or std::wstring, and no iostream overhead:
+//
+//  - for 1-byte characters, the lines are copied as they are, and each block of
+//    complete lines takes a single pool allocation (see BasicAllocator::AllocLines);
+//  - for wider characters, the file is read as UTF-8, and each line is transcoded
+//    into the pool (see BasicAllocator::AllocStringFromUtf8).
+//
+// Copyright (C) by Giovanni Dicanio
+//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "StringPool.h"
+
+#include <cstdint>      // For uint64_t
+#include <cstdio>       // For std::FILE, fopen, fread
+#include <cstring>      // For memmove
+#include <stdexcept>    // For std::runtime_error
+#include <type_traits>  // For std::integral_constant
+#include <vector>       // For std::vector
+
+
+namespace StringPool
+{
+
+//----------------------------------------------------------------------------------------
+// Exception thrown when a file can't be opened or read.
+//----------------------------------------------------------------------------------------
+class FileReadError : public std::runtime_error
+{
+public:
+    explicit FileReadError(const char* message)
+        : std::runtime_error{ message }
+    {}
+};
+
+
+namespace Detail
+{
+
+// Report a file read error.
+// When building without exceptions, the process is aborted.
+[[noreturn]] inline void RaiseFileReadError(const char* message)
+{
+#ifdef STRINGPOOL_NO_EXCEPTIONS
+    (void)message;
+    std::abort();
+#else
+    throw FileReadError(message);
+#endif
+}
+
+} // namespace Detail
+
+
+//----------------------------------------------------------------------------------------
+// Reads the lines of a text file into a string pool, one block at a time.
+//
+// Lines end with "\n" or "\r\n" (the line breaks are not included in the strings),
+// and the text after the last line break (if any) is the last line.
+// A UTF-8 byte order mark at the start of the file is skipped.
+//
+// The pool allocator must outlive the reader (and the strings must not outlive
+// the pool, as usual).
+//
+// StringPool::LineReader reads UTF-8 files into wchar_t strings, and
+// StringPool::NarrowLineReader reads lines of bytes into char strings.
+//----------------------------------------------------------------------------------------
+template <typename CharT, typename AllocatorType = BasicAllocator<CharT>>
+class BasicLineReader
+{
+public:
+    typedef BasicString<CharT> String;
+
+    // Open a file for reading, in blocks of 'blockSizeInBytes'
+    // (longer lines are read anyway).
+    // Throws StringPool::FileReadError if the file can't be opened.
+    BasicLineReader(const char* path, AllocatorType& allocator,
+                    size_t blockSizeInBytes = kDefaultBlockSize)
+        : m_allocator{ &allocator }
+        , m_buffer(blockSizeInBytes != 0 ? blockSizeInBytes : kDefaultBlockSize)
+    {
+#if defined(_MSC_VER)
+        if (fopen_s(&m_file, path, "rb") != 0)
+        {
+            m_file = nullptr;
+        }
+#else
+        m_file = fopen(path, "rb");
+#endif
+        if (m_file == nullptr)
+        {
+            Detail::RaiseFileReadError("StringPool: can't open the file");
+        }
+
+        // The blocks are read directly into our buffer
+        setvbuf(m_file, nullptr, _IONBF, 0);
+    }
+
+    ~BasicLineReader()
+    {
+        if (m_file != nullptr)
+        {
+            fclose(m_file);
+        }
+    }
+
+    // Ban copy
+    BasicLineReader(const BasicLineReader&) = delete;
+    BasicLineReader& operator=(const BasicLineReader&) = delete;
+
+    // Read the next block of the file, appending its complete lines to 'lines'.
+    // Returns false when the whole file has been read (and no lines were appended).
+    // Throws StringPool::FileReadError on read errors, StringPool::InvalidUtf8
+    // if the file is not valid UTF-8 (for wide characters), and std::bad_alloc
+    // on allocation failure.
+    bool ReadLines(std::vector<String>& lines)
+    {
+        if (m_endOfFile && m_pending == 0)
+        {
+            return false;
+        }
+
+        // Lines longer than the buffer: make room for more
+        if (m_pending == m_buffer.size())
+        {
+            m_buffer.resize(m_buffer.size() * 2);
+        }
+
+        size_t begin = 0;
+        size_t end = m_pending;
+        if (!m_endOfFile)
+        {
+            const size_t requested = m_buffer.size() - m_pending;
+            const size_t read = fread(m_buffer.data() + m_pending, 1, requested, m_file);
+            if (read < requested)
+            {
+                if (ferror(m_file))
+                {
+                    Detail::RaiseFileReadError("StringPool: can't read the file");
+                }
+                m_endOfFile = true;
+            }
+
+            m_bytesRead += read;
+            end += read;
+        }
+
+        // Skip the byte order mark at the start of the file
+        // (nothing is emitted before its first 3 bytes have been read)
+        if (m_atStart)
+        {
+            if (end < 3 && !m_endOfFile)
+            {
+                m_pending = end;
+                return true;
+            }
+
+            m_atStart = false;
+            if (end >= 3 && memcmp(m_buffer.data(), "\xEF\xBB\xBF", 3) == 0)
+            {
+                begin = 3;
+            }
+        }
+
+        // Emit the complete lines, and keep the last partial one for the next block
+        // (at the end of the file, the partial line is the last line)
+        size_t complete = end;
+        if (!m_endOfFile)
+        {
+            while (complete > begin && m_buffer[complete - 1] != '\n')
+            {
+                --complete;
+            }
+        }
+
+        EmitLines(m_buffer.data() + begin, m_buffer.data() + complete, lines,
+                  std::integral_constant<bool, sizeof(CharT) == 1>{});
+
+        m_pending = end - complete;
+        if (m_pending != 0)
+        {
+            memmove(m_buffer.data(), m_buffer.data() + complete, m_pending);
+        }
+        return true;
+    }
+
+    // Read the rest of the file, appending its lines to 'lines'.
+    void ReadAllLines(std::vector<String>& lines)
+    {
+        while (ReadLines(lines))
+        {
+        }
+    }
+
+    // Number of bytes read from the file.
+    uint64_t BytesRead() const noexcept
+    {
+        return m_bytesRead;
+    }
+
+
+private:
+    enum : size_t
+    {
+        kDefaultBlockSize = 1024 * 1024
+    };
+
+    AllocatorType* m_allocator;
+    std::FILE* m_file{};
+    std::vector<char> m_buffer;
+    size_t m_pending{};         // Bytes of the partial line at the start of the buffer
+    uint64_t m_bytesRead{};
+    bool m_endOfFile{};
+    bool m_atStart{ true };     // Byte order mark not checked yet
+
+    // 1-byte characters: copy the block of lines with a single allocation.
+    void EmitLines(const char* start, const char* finish, std::vector<String>& lines,
+                   std::true_type)
+    {
+        m_allocator->AllocLines(reinterpret_cast<const CharT*>(start),
+                                reinterpret_cast<const CharT*>(finish), lines);
+    }
+
+    // Wider characters: transcode each UTF-8 line into the pool.
+    void EmitLines(const char* start, const char* finish, std::vector<String>& lines,
+                   std::false_type)
+    {
+        if (start != finish && finish[-1] == '\n')
+        {
+            --finish;
+        }
+        else if (start == finish)
+        {
+            return;
+        }
+
+        for (;;)
+        {
+            const size_t length = Detail::FindChar(start, finish - start, '\n');
+            const char* lineEnd = start + length;
+            const char* next = lineEnd + 1;
+            if (lineEnd != start && lineEnd[-1] == '\r')
+            {
+                --lineEnd;
+            }
+
+            lines.push_back(m_allocator->AllocStringFromUtf8(start, lineEnd));
+
+            if (next > finish)
+            {
+                break;
+            }
+            start = next;
+        }
+    }
+};
+
+// Line readers for UTF-8 files into wchar_t strings, and for lines of bytes
+// into char strings.
+using LineReader = BasicLineReader<wchar_t>;
+using NarrowLineReader = BasicLineReader<char>;
+
+// Read all the lines of a text file into the pool, appending them to 'lines'
+// (see BasicLineReader).
+template <typename CharT, typename Instrumentation>
+inline void ReadLines(const char* path, BasicAllocator<CharT, Instrumentation>& allocator,
+                      std::vector<BasicString<CharT>>& lines)
+{
+    BasicLineReader<CharT, BasicAllocator<CharT, Instrumentation>> reader{ path, allocator };
+    reader.ReadAllLines(lines);
+}
+
+} // namespace StringPool
+
+
+#endif // INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_READER_H
@@ -0,0 +1,487 @@
+#ifndef INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_SHARED_H
+#define INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_SHARED_H
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//
+// Read-only string pools in shared memory (StringPool::SharedPool), to share a single
+// string dictionary among several processes on the same host, instead of each process
+// holding its own copy.
+//
+// As the shared memory can be mapped at different addresses in each process, strings
+// are referenced with offset-based handles (StringPool::RelativeString), that are valid
+// in every process mapping the pool, and can be stored in shared memory too.
+// The pool content uses the relocatable snapshot layout (see StringPoolSnapshot.h).
+//
+// Requires POSIX shared memory (shm_open); anonymous pools (memfd_create) require Linux.
+// STRINGPOOL_HAS_SHARED_POOL and STRINGPOOL_HAS_MEMFD are defined when available.
+//
+// Copyright (C) by Giovanni Dicanio
+//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "StringPoolSnapshot.h"
+
+#include <atomic>       // For std::atomic_thread_fence
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>      // For O_CREAT, fcntl
+#include <sys/mman.h>   // For shm_open, mmap, memfd_create
+#include <sys/stat.h>   // For fstat
+#include <unistd.h>     // For ftruncate, close
+#define STRINGPOOL_HAS_SHARED_POOL
+#if defined(__linux__) && defined(MFD_ALLOW_SEALING)
+#define STRINGPOOL_HAS_MEMFD
+#endif
+#endif
+
+
+#ifdef STRINGPOOL_HAS_SHARED_POOL
+
+namespace StringPool
+{
+
+//----------------------------------------------------------------------------------------
+// Relocatable handle to a string of a shared pool: the offset of its characters
+// in the pool, and its length.
+//
+// Unlike String, this handle contains no pointers, so it's valid in every process
+// mapping the pool (at any address); resolve it with BasicSharedPool::Resolve.
+// It has the layout of the handle table entries of snapshots.
+//----------------------------------------------------------------------------------------
+template <typename CharT>
+class BasicRelativeString
+{
+public:
+
+    // Creates a handle to an empty string.
+    BasicRelativeString() noexcept = default;
+
+    // Offset of the first character, in the characters of the pool.
+    uint64_t Offset() const noexcept
+    {
+        return m_offset;
+    }
+
+    // Number of characters in the string (excluding the terminating NUL).
+    size_t Length() const noexcept
+    {
+        return static_cast<size_t>(m_length);
+    }
+
+    bool IsEmpty() const noexcept
+    {
+        return m_length == 0;
+    }
+
+private:
+    uint64_t m_offset{};
+    uint64_t m_length{};
+};
+
+// Relocatable handle to a shared pool string of wchar_t.
+using RelativeString = BasicRelativeString<wchar_t>;
+
+
+namespace Detail
+{
+
+// Snapshot sink writing to memory.
+class SnapshotMemory
+{
+public:
+    explicit SnapshotMemory(uint8_t* pData) noexcept
+        : m_pNext{ pData }
+    {}
+
+    void Write(const void* data, size_t sizeInBytes) noexcept
+    {
+        if (sizeInBytes != 0)
+        {
+            memcpy(m_pNext, data, sizeInBytes);
+            m_pNext += sizeInBytes;
+        }
+    }
+
+private:
+    uint8_t* m_pNext;
+};
+
+} // namespace Detail
+
+
+//----------------------------------------------------------------------------------------
+// Read-only string pool in shared memory.
+//
+// A producer process creates the pool from its strings (Create, or CreateAnonymous),
+// copying them once into a shared memory region; the worker processes map the same
+// region read-only (Open, or FromFd), with no copies.
+// The pool strings are identified by their index, in the order of creation,
+// or by their relocatable handles.
+//
+// The String objects returned by Resolve point into this process mapping: they are
+// valid as long as this object is alive, and must not be stored in shared memory
+// (store the RelativeString handles instead).
+//
+// StringPool::SharedPool stores wchar_t strings.
+//----------------------------------------------------------------------------------------
+template <typename CharT>
+class BasicSharedPool
+{
+public:
+
+    // The types of the strings in the pool
+    typedef BasicString<CharT> String;
+    typedef BasicRelativeString<CharT> RelativeString;
+
+    // Creates an empty pool, with no strings.
+    BasicSharedPool() = default;
+
+    // Unmap the pool (and close its memfd, if any).
+    ~BasicSharedPool()
+    {
+        Unmap();
+    }
+
+    // Ban copy
+    BasicSharedPool(const BasicSharedPool&) = delete;
+    BasicSharedPool& operator=(const BasicSharedPool&) = delete;
+
+    // Move the mapping from the other pool, leaving it empty.
+    BasicSharedPool(BasicSharedPool&& other) noexcept
+    {
+        swap(*this, other);
+    }
+
+    // Unmap this pool, and move the mapping from the other pool, leaving it empty.
+    BasicSharedPool& operator=(BasicSharedPool&& other) noexcept
+    {
+        if (&other != this)
+        {
+            BasicSharedPool temp{ std::move(other) };
+            swap(*this, temp);
+        }
+        return *this;
+    }
+
+    // STL-style non-throwing swap
+    friend void swap(BasicSharedPool& a, BasicSharedPool& b) noexcept
+    {
+        using std::swap;
+        swap(a.m_pData,       b.m_pData);
+        swap(a.m_sizeInBytes, b.m_sizeInBytes);
+        swap(a.m_fd,          b.m_fd);
+        swap(a.m_handles,     b.m_handles);
+        swap(a.m_chars,       b.m_chars);
+        swap(a.m_count,       b.m_count);
+    }
+
+    //
+    // Creation and mapping.
+    // These functions throw StringPool::SnapshotError on failure,
+    // e.g. if the shared memory object can't be created or mapped, or doesn't contain
+    // a valid pool for this character type (abort if STRINGPOOL_NO_EXCEPTIONS
+    // is defined).
+    //
+
+    // Create the named shared memory object 'name' (e.g. "/my-dictionary",
+    // see shm_open), that must not exist, with a copy of the 'count' strings.
+    // The object persists until Remove is called, even after this process exits.
+    static BasicSharedPool Create(const char* name, const String* strings, size_t count)
+    {
+        const int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0)
+        {
+            Detail::RaiseSnapshotError("StringPool: can't create the shared memory");
+        }
+
+        BasicSharedPool pool;
+        pool.m_fd = fd;     // Closed after mapping
+
+#ifdef STRINGPOOL_NO_EXCEPTIONS
+        pool.Fill(strings, count, false);
+#else
+        try
+        {
+            pool.Fill(strings, count, false);
+        }
+        catch (...)
+        {
+            shm_unlink(name);
+            throw;
+        }
+#endif
+        pool.CloseFd();
+        return pool;
+    }
+
+    static BasicSharedPool Create(const char* name, const std::vector<String>& strings)
+    {
+        return Create(name, strings.data(), strings.size());
+    }
+
+    // Map the named shared memory object 'name', created by Create.
+    // Fails if the producer is still writing it (the caller can retry later).
+    static BasicSharedPool Open(const char* name)
+    {
+        const int fd = shm_open(name, O_RDONLY, 0);
+        if (fd < 0)
+        {
+            Detail::RaiseSnapshotError("StringPool: can't open the shared memory");
+        }
+
+        BasicSharedPool pool;
+        pool.m_fd = fd;
+        pool.Map();
+        pool.CloseFd();
+        return pool;
+    }
+
+    // Remove the name of a shared memory object created by Create: the processes
+    // that have already mapped it keep using it, and its memory is released when
+    // they all unmap it.
+    // Returns false if the name doesn't exist.
+    static bool Remove(const char* name) noexcept
+    {
+        return shm_unlink(name) == 0;
+    }
+
+#ifdef STRINGPOOL_HAS_MEMFD
+
+    // Create an anonymous pool (see memfd_create), with a copy of the 'count' strings.
+    // The memfd is sealed against writes and resizes, so the processes receiving it
+    // (e.g. inherited with fork, or passed with SCM_RIGHTS) can't modify the pool.
+    // The memory is released when the last memfd and mapping are closed.
+    static BasicSharedPool CreateAnonymous(const String* strings, size_t count)
+    {
+        const int fd = memfd_create("StringPool", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (fd < 0)
+        {
+            Detail::RaiseSnapshotError("StringPool: can't create the shared memory");
+        }
+
+        BasicSharedPool pool;
+        pool.m_fd = fd;     // Kept open, to share it
+        pool.Fill(strings, count, true);
+        return pool;
+    }
+
+    static BasicSharedPool CreateAnonymous(const std::vector<String>& strings)
+    {
+        return CreateAnonymous(strings.data(), strings.size());
+    }
+
+    // Map the pool of a memfd created by CreateAnonymous (in this or another process).
+    // The file descriptor is not owned: the caller can close it after this call.
+    static BasicSharedPool FromFd(int fd)
+    {
+        // Only accept sealed memfds, that can't change under the mapping
+        const int seals = fcntl(fd, F_GET_SEALS);
+        if (seals < 0 || (seals & kSeals) != kSeals)
+        {
+            Detail::RaiseSnapshotError("StringPool: invalid shared memory");
+        }
+
+        BasicSharedPool pool;
+        pool.m_fd = fd;
+        pool.Map();
+        pool.m_fd = -1;     // Not owned
+        return pool;
+    }
+
+    // The memfd of a pool created by CreateAnonymous (-1 for other pools),
+    // to be shared with other processes. It's closed by this object.
+    int Fd() const noexcept
+    {
+        return m_fd;
+    }
+
+#endif // STRINGPOOL_HAS_MEMFD
+
+    //
+    // String access.
+    //
+
+    // Number of strings in the pool.
+    size_t Count() const noexcept
+    {
+        return m_count;
+    }
+
+    // Relocatable handle of the string at 'index' (index < Count()).
+    const RelativeString& Handle(size_t index) const noexcept
+    {
+        return m_handles[index];
+    }
+
+    // The string at 'index' (index < Count()), pointing into this process mapping.
+    String operator[](size_t index) const noexcept
+    {
+        return Resolve(m_handles[index]);
+    }
+
+    // The string of a handle of this pool, pointing into this process mapping.
+    String Resolve(const RelativeString& handle) const noexcept
+    {
+        if (handle.IsEmpty())
+        {
+            return String{};
+        }
+
+        return String{ m_chars + handle.Offset(), handle.Length() };
+    }
+
+    // Size of the shared memory, in bytes.
+    size_t SizeInBytes() const noexcept
+    {
+        return m_sizeInBytes;
+    }
+
+
+private:
+    const uint8_t* m_pData{};           // The mapped shared memory
+    size_t m_sizeInBytes{};
+    int m_fd{ -1 };                     // Owned file descriptor, if any
+
+    const RelativeString* m_handles{};  // Handle table in the shared memory
+    const CharT* m_chars{};             // Characters in the shared memory
+    size_t m_count{};
+
+#ifdef STRINGPOOL_HAS_MEMFD
+    enum
+    {
+        // Seals of anonymous pools: no writes, no resizes, no seal changes
+        kSeals = F_SEAL_SEAL | F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE
+    };
+#endif
+
+    static_assert(sizeof(RelativeString) == sizeof(Detail::SnapshotEntry),
+                  "Relative strings must match the snapshot handle table.");
+
+    // Size the shared memory of m_fd, write the snapshot of the strings into it,
+    // and map it read-only (sealing it before, for memfds).
+    void Fill(const String* strings, size_t count, bool seal)
+    {
+        const Detail::SnapshotHeader header = Detail::MakeSnapshotHeader(strings, count);
+        const uint64_t sizeInBytes = Detail::SnapshotSizeInBytes(header);
+        if (sizeInBytes > static_cast<uint64_t>(SIZE_MAX >> 1)
+            || ftruncate(m_fd, static_cast<off_t>(sizeInBytes)) != 0)
+        {
+            Detail::RaiseSnapshotError("StringPool: can't size the shared memory");
+        }
+
+        const size_t size = static_cast<size_t>(sizeInBytes);
+        void* pView = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        if (pView == MAP_FAILED)
+        {
+            Detail::RaiseSnapshotError("StringPool: can't map the shared memory");
+        }
+
+        // Write the magic last, so processes opening the pool early reject it
+        // as invalid, instead of reading partial content
+        Detail::SnapshotHeader pendingHeader = header;
+        memset(pendingHeader.Magic, 0, sizeof(pendingHeader.Magic));
+
+        Detail::SnapshotMemory memory{ static_cast<uint8_t*>(pView) };
+        Detail::WriteSnapshot(memory, pendingHeader, strings, count);
+
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(pView, Detail::kSnapshotMagic, sizeof(header.Magic));
+
+        // Writable mappings prevent the write seal: map the pool again, read-only
+        munmap(pView, size);
+
+#ifdef STRINGPOOL_HAS_MEMFD
+        if (seal && fcntl(m_fd, F_ADD_SEALS, kSeals) != 0)
+        {
+            Detail::RaiseSnapshotError("StringPool: can't seal the shared memory");
+        }
+#else
+        (void)seal;
+#endif
+
+        Map();
+    }
+
+    // Map the shared memory of m_fd read-only, and validate its content.
+    void Map()
+    {
+        struct stat info{};
+        if (fstat(m_fd, &info) != 0 || info.st_size <= 0
+            || static_cast<unsigned long long>(info.st_size) > SIZE_MAX)
+        {
+            Detail::RaiseSnapshotError("StringPool: invalid shared memory");
+        }
+
+        const size_t size = static_cast<size_t>(info.st_size);
+        void* pView = mmap(nullptr, size, PROT_READ, MAP_SHARED, m_fd, 0);
+        if (pView == MAP_FAILED)
+        {
+            Detail::RaiseSnapshotError("StringPool: can't map the shared memory");
+        }
+
+        m_pData = static_cast<const uint8_t*>(pView);
+        m_sizeInBytes = size;
+
+        // The writer stores the magic last, after a release fence: check it first,
+        // and read the rest of the header and the strings only after the acquire fence
+        if (m_sizeInBytes < sizeof(Detail::SnapshotHeader)
+            || memcmp(m_pData, Detail::kSnapshotMagic, sizeof(Detail::kSnapshotMagic)) != 0)
+        {
+            Detail::RaiseSnapshotError("StringPool: invalid shared memory");
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        const Detail::SnapshotHeader header =
+            Detail::ReadSnapshotHeader<CharT>(m_pData, m_sizeInBytes);
+
+        m_handles = reinterpret_cast<const RelativeString*>(m_pData + sizeof(header));
+        m_chars = reinterpret_cast<const CharT*>(m_handles + header.StringCount);
+        m_count = static_cast<size_t>(header.StringCount);
+
+        // Validate the handles once, so Resolve doesn't need bounds checks
+        for (size_t i = 0; i < m_count; ++i)
+        {
+            if (!Detail::IsValidSnapshotEntry(m_handles[i].Offset(), m_handles[i].Length(),
+                                              m_chars, header.CharCount))
+            {
+                Detail::RaiseSnapshotError("StringPool: invalid shared memory");
+            }
+        }
+    }
+
+    void CloseFd() noexcept
+    {
+        if (m_fd >= 0)
+        {
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    // Unmap the shared memory (if any), and close the owned file descriptor.
+    void Unmap() noexcept
+    {
+        if (m_pData != nullptr)
+        {
+            munmap(const_cast<uint8_t*>(m_pData), m_sizeInBytes);
+        }
+        CloseFd();
+
+        m_pData = nullptr;
+        m_sizeInBytes = 0;
+        m_handles = nullptr;
+        m_chars = nullptr;
+        m_count = 0;
+    }
+};
+
+// Shared pool of wchar_t strings (StringPool::String).
+using SharedPool = BasicSharedPool<wchar_t>;
+
+} // namespace StringPool
+
+#endif // STRINGPOOL_HAS_SHARED_POOL
+
+
+#endif // INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_SHARED_H
@@ -0,0 +1,414 @@
+#ifndef INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_SIMD_H
+#define INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_SIMD_H
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//
+// SIMD kernels used by the string pool (StringPool::String comparisons).
+//
+// On x86/x64 there are SSE2 and AVX2 versions, and the best one for the CPU
+// is selected at runtime; on other platforms a portable scalar version is used.
+// Define STRINGPOOL_NO_SIMD to always use the portable version.
+//
+// The kernels work on bytes, so they serve strings of any character type.
+// Note that memcmp, and glibc's wmemcmp, are already vectorized and dispatched 
+// at runtime, so they're used for three-way comparisons of char and wchar_t strings
+// on those platforms; elsewhere (e.g. wchar_t on MSVC, where wmemcmp is a scalar loop,
+// or char16_t and char32_t) comparisons use the kernels in this file.
+//
+// Copyright (C) by Giovanni Dicanio
+//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cstddef>      // For size_t
+#include <cstdint>      // For uint8_t, uint32_t
+#include <cstring>      // For memcmp
+#include <cwchar>       // For wmemcmp
+#include <string>       // For std::char_traits
+
+#if !defined(STRINGPOOL_NO_SIMD) \
+    && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define STRINGPOOL_HAS_SSE2
+#include <immintrin.h>  // For SSE2 and AVX2 intrinsics
+#if defined(_MSC_VER)
+#include <intrin.h>     // For __cpuid, _BitScanForward
+#endif
+#endif
+
+// Mark functions that use AVX2 instructions
+// (MSVC doesn't need that, while GCC and Clang do, unless compiling with -mavx2)
+#if defined(__GNUC__) || defined(__clang__)
+#define STRINGPOOL_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define STRINGPOOL_TARGET_AVX2
+#endif
+
+
+namespace StringPool
+{
+namespace Detail
+{
+
+// Return the index of the first mismatching character between a[0, length)
+// and b[0, length), or 'length' if they are equal.
+template <typename CharT>
+inline size_t MismatchScalar(const CharT* a, const CharT* b, size_t length) noexcept
+{
+    size_t i = 0;
+    while (i < length && a[i] == b[i])
+    {
+        ++i;
+    }
+    return i;
+}
+
+
+#ifdef STRINGPOOL_HAS_SSE2
+
+// Index of the lowest set bit of a non-zero mask.
+inline unsigned int LowestSetBit(uint32_t mask) noexcept
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+}
+
+// SSE2 version of MismatchScalar on bytes: compares 16 bytes at a time.
+inline size_t MismatchSse2(const uint8_t* pa, const uint8_t* pb, size_t lengthInBytes) noexcept
+{
+    size_t i = 0;
+    for (; i + 16 <= lengthInBytes; i += 16)
+    {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pa + i));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pb + i));
+        const uint32_t equalMask = static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)));
+
+        if (equalMask != 0xFFFF)
+        {
+            return i + LowestSetBit(~equalMask);
+        }
+    }
+
+    return i + MismatchScalar(pa + i, pb + i, lengthInBytes - i);
+}
+
+// AVX2 version of MismatchScalar on bytes: compares 32 bytes at a time.
+STRINGPOOL_TARGET_AVX2
+inline size_t MismatchAvx2(const uint8_t* pa, const uint8_t* pb, size_t lengthInBytes) noexcept
+{
+    size_t i = 0;
+
+    // Main loop: 128 bytes per iteration, with a single mask test
+    for (; i + 128 <= lengthInBytes; i += 128)
+    {
+        const __m256i* va = reinterpret_cast<const __m256i*>(pa + i);
+        const __m256i* vb = reinterpret_cast<const __m256i*>(pb + i);
+        const __m256i equal0 = _mm256_cmpeq_epi8(_mm256_loadu_si256(va),
+                                                 _mm256_loadu_si256(vb));
+        const __m256i equal1 = _mm256_cmpeq_epi8(_mm256_loadu_si256(va + 1),
+                                                 _mm256_loadu_si256(vb + 1));
+        const __m256i equal2 = _mm256_cmpeq_epi8(_mm256_loadu_si256(va + 2),
+                                                 _mm256_loadu_si256(vb + 2));
+        const __m256i equal3 = _mm256_cmpeq_epi8(_mm256_loadu_si256(va + 3),
+                                                 _mm256_loadu_si256(vb + 3));
+        const __m256i allEqual = _mm256_and_si256(_mm256_and_si256(equal0, equal1),
+                                                  _mm256_and_si256(equal2, equal3));
+
+        if (static_cast<uint32_t>(_mm256_movemask_epi8(allEqual)) != 0xFFFFFFFF)
+        {
+            // Locate the mismatch in the 32-byte blocks below
+            break;
+        }
+    }
+
+    for (; i + 32 <= lengthInBytes; i += 32)
+    {
+        const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pa + i));
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pb + i));
+        const uint32_t equalMask = static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)));
+
+        if (equalMask != 0xFFFFFFFF)
+        {
+            return i + LowestSetBit(~equalMask);
+        }
+    }
+
+    return i + MismatchSse2(pa + i, pb + i, lengthInBytes - i);
+}
+
+// Check if the CPU and the OS support AVX2.
+inline bool CpuHasAvx2() noexcept
+{
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7)
+    {
+        return false;
+    }
+
+    // The OS must save the YMM registers (OSXSAVE and XCR0 bits 1 and 2)
+    __cpuid(regs, 1);
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif // STRINGPOOL_HAS_SSE2
+
+
+typedef size_t (*MismatchFunction)(const uint8_t*, const uint8_t*, size_t);
+
+// Pick the best byte mismatch kernel for the current CPU.
+inline MismatchFunction SelectMismatchFunction() noexcept
+{
+#ifdef STRINGPOOL_HAS_SSE2
+    if (CpuHasAvx2())
+    {
+        return MismatchAvx2;
+    }
+    return MismatchSse2;
+#else
+    return MismatchScalar<uint8_t>;
+#endif
+}
+
+// Return the index of the first mismatching byte between a[0, lengthInBytes)
+// and b[0, lengthInBytes), or 'lengthInBytes' if they are equal.
+// Dispatches to the best SIMD kernel for the current CPU.
+inline size_t MismatchBytes(const void* a, const void* b, size_t lengthInBytes) noexcept
+{
+    static const MismatchFunction mismatch = SelectMismatchFunction();
+    return mismatch(static_cast<const uint8_t*>(a), static_cast<const uint8_t*>(b), 
+                    lengthInBytes);
+}
+
+// Return the index of the first mismatching character between a[0, length)
+// and b[0, length), or 'length' if they are equal.
+template <typename CharT>
+inline size_t Mismatch(const CharT* a, const CharT* b, size_t length) noexcept
+{
+#ifdef STRINGPOOL_HAS_SSE2
+    // The first mismatching byte belongs to the first mismatching character
+    return MismatchBytes(a, b, length * sizeof(CharT)) / sizeof(CharT);
+#else
+    return MismatchScalar(a, b, length);
+#endif
+}
+
+// Return the index of the first occurrence of ch in s[0, length), 
+// or 'length' if it's not found.
+template <typename CharT>
+inline size_t FindCharScalar(const CharT* s, size_t length, CharT ch) noexcept
+{
+    size_t i = 0;
+    while (i < length && s[i] != ch)
+    {
+        ++i;
+    }
+    return i;
+}
+
+// Copy source[0, length) to dest, up to the first occurrence of ch (excluded);
+// return the index of ch, or 'length' if it's not found.
+template <typename CharT>
+inline size_t CopyUntilCharScalar(CharT* dest, const CharT* source, size_t length, 
+                                  CharT ch) noexcept
+{
+    size_t i = 0;
+    while (i < length && source[i] != ch)
+    {
+        dest[i] = source[i];
+        ++i;
+    }
+    return i;
+}
+
+#ifdef STRINGPOOL_HAS_SSE2
+
+// SSE2 comparisons of 1, 2 and 4-byte characters.
+template <size_t CharSize> struct SimdChars;
+
+template <>
+struct SimdChars<1>
+{
+    static __m128i Broadcast(uint32_t ch) noexcept 
+    { 
+        return _mm_set1_epi8(static_cast<char>(ch)); 
+    }
+
+    static __m128i Equal(__m128i a, __m128i b) noexcept 
+    { 
+        return _mm_cmpeq_epi8(a, b); 
+    }
+};
+
+template <>
+struct SimdChars<2>
+{
+    static __m128i Broadcast(uint32_t ch) noexcept 
+    { 
+        return _mm_set1_epi16(static_cast<short>(ch)); 
+    }
+
+    static __m128i Equal(__m128i a, __m128i b) noexcept 
+    { 
+        return _mm_cmpeq_epi16(a, b); 
+    }
+};
+
+template <>
+struct SimdChars<4>
+{
+    static __m128i Broadcast(uint32_t ch) noexcept 
+    { 
+        return _mm_set1_epi32(static_cast<int>(ch)); 
+    }
+
+    static __m128i Equal(__m128i a, __m128i b) noexcept 
+    { 
+        return _mm_cmpeq_epi32(a, b); 
+    }
+};
+
+// SSE2 version of FindCharScalar: checks 16 bytes of characters at a time,
+// two blocks per iteration.
+template <typename CharT>
+inline size_t FindCharSse2(const CharT* s, size_t length, CharT ch) noexcept
+{
+    typedef SimdChars<sizeof(CharT)> Ops;
+    const size_t kBlockLength = 16 / sizeof(CharT);
+
+    const __m128i pattern = Ops::Broadcast(static_cast<uint32_t>(ch));
+    size_t i = 0;
+
+    for (; i + 2 * kBlockLength <= length; i += 2 * kBlockLength)
+    {
+        const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        const __m128i v1 = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(s + i + kBlockLength));
+        const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(Ops::Equal(v0, pattern)))
+            | (static_cast<uint32_t>(_mm_movemask_epi8(Ops::Equal(v1, pattern))) << 16);
+
+        if (mask != 0)
+        {
+            // All the bytes of a matching character are set in the mask
+            return i + LowestSetBit(mask) / sizeof(CharT);
+        }
+    }
+
+    return i + FindCharScalar(s + i, length - i, ch);
+}
+
+// SSE2 version of CopyUntilCharScalar: the scanned blocks of 16 bytes are stored 
+// as they are, including the one with the match.
+template <typename CharT>
+inline size_t CopyUntilCharSse2(CharT* dest, const CharT* source, size_t length, 
+                                CharT ch) noexcept
+{
+    typedef SimdChars<sizeof(CharT)> Ops;
+    const size_t kBlockLength = 16 / sizeof(CharT);
+
+    const __m128i pattern = Ops::Broadcast(static_cast<uint32_t>(ch));
+    size_t i = 0;
+
+    for (; i + kBlockLength <= length; i += kBlockLength)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), v);
+
+        const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(Ops::Equal(v, pattern)));
+        if (mask != 0)
+        {
+            return i + LowestSetBit(mask) / sizeof(CharT);
+        }
+    }
+
+    return i + CopyUntilCharScalar(dest + i, source + i, length - i, ch);
+}
+
+#endif // STRINGPOOL_HAS_SSE2
+
+// Return the index of the first occurrence of ch in s[0, length), 
+// or 'length' if it's not found.
+template <typename CharT>
+inline size_t FindChar(const CharT* s, size_t length, CharT ch) noexcept
+{
+#ifdef STRINGPOOL_HAS_SSE2
+    return FindCharSse2(s, length, ch);
+#else
+    return FindCharScalar(s, length, ch);
+#endif
+}
+
+// Copy source[0, length) to dest[0, length), up to the first occurrence of ch,
+// in a single pass; return the index of ch, or 'length' if it's not found.
+// The characters after ch may be copied too (dest must have room for 'length'
+// characters).
+template <typename CharT>
+inline size_t CopyUntilChar(CharT* dest, const CharT* source, size_t length, 
+                            CharT ch) noexcept
+{
+#ifdef STRINGPOOL_HAS_SSE2
+    return CopyUntilCharSse2(dest, source, length, ch);
+#else
+    return CopyUntilCharScalar(dest, source, length, ch);
+#endif
+}
+
+// Compare two character arrays, in the order of std::char_traits<CharT>::compare.
+// Returns a negative value, 0 or a positive value, like memcmp.
+template <typename CharT>
+inline int CompareChars(const CharT* a, const CharT* b, size_t length) noexcept
+{
+    const size_t mismatch = Mismatch(a, b, length);
+    if (mismatch == length)
+    {
+        return 0;
+    }
+
+    return std::char_traits<CharT>::lt(a[mismatch], b[mismatch]) ? -1 : 1;
+}
+
+// Byte strings compare as unsigned chars, just like memcmp
+template <>
+inline int CompareChars<char>(const char* a, const char* b, size_t length) noexcept
+{
+    return memcmp(a, b, length);
+}
+
+#if defined(__cpp_char8_t)
+template <>
+inline int CompareChars<char8_t>(const char8_t* a, const char8_t* b, size_t length) noexcept
+{
+    return memcmp(a, b, length);
+}
+#endif
+
+#if defined(__GLIBC__)
+template <>
+inline int CompareChars<wchar_t>(const wchar_t* a, const wchar_t* b, size_t length) noexcept
+{
+    return wmemcmp(a, b, length);
+}
+#endif
+
+} // namespace Detail
+} // namespace StringPool
+
+
+#endif // INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_SIMD_H
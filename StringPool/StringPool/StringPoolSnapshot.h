@@ -0,0 +1,633 @@
+#ifndef INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_SNAPSHOT_H
+#define INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_SNAPSHOT_H
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//
+// Binary snapshots of pooled strings: StringPool::SaveSnapshot writes a vector of
+// String handles, with their characters, to a single relocatable file,
+// and StringPool::Snapshot memory-maps it read-only, and reconstructs the handles
+// pointing *into the mapped file*, with no character copies.
+//
+// This way, a large dictionary can be built once, and reloaded at startup in the time
+// taken to rebuild the handles (the characters are paged in on first access).
+//
+// Saving is portable; loading requires memory-mapped files (Windows, or POSIX mmap):
+// STRINGPOOL_HAS_SNAPSHOT is defined when the loader is available.
+//
+// Copyright (C) by Giovanni Dicanio
+//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "StringPool.h"
+
+#include <cstdio>       // For std::FILE, fopen, fwrite, std::rename, std::remove
+#include <stdexcept>    // For std::runtime_error
+#include <string>       // For std::string
+
+#if defined(_WIN32)
+// Keep the min/max macros (and the rarely used APIs) of <Windows.h> out of the
+// code including this header
+#ifndef NOMINMAX
+#define NOMINMAX
+#define STRINGPOOL_SNAPSHOT_DEFINED_NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#define STRINGPOOL_SNAPSHOT_DEFINED_WIN32_LEAN_AND_MEAN
+#endif
+#include <Windows.h>    // For CreateFileMapping, MapViewOfFile, MoveFileEx
+#ifdef STRINGPOOL_SNAPSHOT_DEFINED_NOMINMAX
+#undef NOMINMAX
+#undef STRINGPOOL_SNAPSHOT_DEFINED_NOMINMAX
+#endif
+#ifdef STRINGPOOL_SNAPSHOT_DEFINED_WIN32_LEAN_AND_MEAN
+#undef WIN32_LEAN_AND_MEAN
+#undef STRINGPOOL_SNAPSHOT_DEFINED_WIN32_LEAN_AND_MEAN
+#endif
+#define STRINGPOOL_HAS_SNAPSHOT
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>      // For open
+#include <sys/mman.h>   // For mmap, munmap
+#include <sys/stat.h>   // For fstat
+#include <unistd.h>     // For close
+#define STRINGPOOL_HAS_SNAPSHOT
+#endif
+
+
+namespace StringPool
+{
+
+//----------------------------------------------------------------------------------------
+// Exception thrown when a snapshot file can't be written, read, or is not valid.
+//----------------------------------------------------------------------------------------
+class SnapshotError : public std::runtime_error
+{
+public:
+    explicit SnapshotError(const char* message)
+        : std::runtime_error{ message }
+    {}
+};
+
+
+namespace Detail
+{
+
+//
+// Snapshot file layout (all the offsets are relative, so the file can be mapped
+// at any address):
+//
+//      SnapshotHeader
+//      SnapshotEntry[StringCount]  : the String handles, in the saved order
+//      CharT[CharCount]            : the characters of the non-empty strings,
+//                                    each one followed by its NUL
+//
+// The integers are stored in the byte order of the writer, and the loader rejects
+// files with a different byte order or character size.
+//
+
+const char kSnapshotMagic[8] = { 'S', 't', 'r', 'P', 'o', 'o', 'l', '\0' };
+const uint32_t kSnapshotVersion = 1;
+const uint32_t kSnapshotByteOrderMark = 0x01020304;
+
+struct SnapshotHeader
+{
+    char     Magic[8];          // kSnapshotMagic
+    uint32_t Version;           // kSnapshotVersion
+    uint32_t ByteOrderMark;     // kSnapshotByteOrderMark, in the writer byte order
+    uint32_t CharSize;          // sizeof(CharT)
+    uint32_t Reserved;
+    uint64_t StringCount;       // Number of SnapshotEntry items
+    uint64_t CharCount;         // Number of characters, including the NULs
+};
+
+struct SnapshotEntry
+{
+    uint64_t Offset;            // Index of the first character (0 for empty strings)
+    uint64_t Length;            // Length, in characters, excluding the terminating NUL
+};
+
+static_assert(sizeof(SnapshotHeader) % 8 == 0 && sizeof(SnapshotEntry) == 16,
+              "The snapshot characters must start 8-byte aligned.");
+
+// Report a snapshot failure.
+// When building without exceptions, the process is aborted.
+[[noreturn]] inline void RaiseSnapshotError(const char* message)
+{
+#ifdef STRINGPOOL_NO_EXCEPTIONS
+    (void)message;
+    std::abort();
+#else
+    throw SnapshotError(message);
+#endif
+}
+
+// Buffered output file used to write snapshots.
+//
+// The snapshot is written to a temporary file next to the target path, and renamed
+// into place by Close: if a write fails, the temporary file is removed and the target
+// path is left untouched, so a truncated snapshot is never loaded.
+class SnapshotFile
+{
+public:
+    explicit SnapshotFile(const char* path)
+        : m_path(path)
+        , m_tempPath(m_path + ".tmp")
+    {
+#if defined(_MSC_VER)
+        if (fopen_s(&m_file, m_tempPath.c_str(), "wb") != 0)
+        {
+            m_file = nullptr;
+        }
+#else
+        m_file = fopen(m_tempPath.c_str(), "wb");
+#endif
+        if (m_file == nullptr)
+        {
+            RaiseSnapshotError("StringPool: can't create the snapshot file");
+        }
+
+        setvbuf(m_file, nullptr, _IOFBF, kBufferSize);
+    }
+
+    ~SnapshotFile()
+    {
+        // Not closed: a write failed, discard the partial file
+        if (m_file != nullptr)
+        {
+            fclose(m_file);
+            std::remove(m_tempPath.c_str());
+        }
+    }
+
+    // Ban copy
+    SnapshotFile(const SnapshotFile&) = delete;
+    SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+    void Write(const void* data, size_t sizeInBytes)
+    {
+        if (sizeInBytes != 0 && fwrite(data, 1, sizeInBytes, m_file) != sizeInBytes)
+        {
+            RaiseSnapshotError("StringPool: can't write the snapshot file");
+        }
+    }
+
+    // Flush and close the file, reporting write errors, then move it to the target path.
+    void Close()
+    {
+        std::FILE* file = m_file;
+        m_file = nullptr;
+        if (fclose(file) != 0)
+        {
+            std::remove(m_tempPath.c_str());
+            RaiseSnapshotError("StringPool: can't write the snapshot file");
+        }
+
+#if defined(_WIN32)
+        // std::rename fails on Windows when the target exists
+        const bool renamed = MoveFileExA(m_tempPath.c_str(), m_path.c_str(),
+            MOVEFILE_REPLACE_EXISTING) != FALSE;
+#else
+        const bool renamed = std::rename(m_tempPath.c_str(), m_path.c_str()) == 0;
+#endif
+        if (!renamed)
+        {
+            std::remove(m_tempPath.c_str());
+            RaiseSnapshotError("StringPool: can't write the snapshot file");
+        }
+    }
+
+private:
+    enum
+    {
+        kBufferSize = 1024 * 1024
+    };
+
+    std::string m_path;
+    std::string m_tempPath;
+    std::FILE* m_file{};
+};
+
+} // namespace Detail
+
+
+namespace Detail
+{
+
+// Prepare the header of the snapshot of the 'count' strings.
+template <typename CharT>
+SnapshotHeader MakeSnapshotHeader(const BasicString<CharT>* strings, size_t count) noexcept
+{
+    SnapshotHeader header{};
+    memcpy(header.Magic, kSnapshotMagic, sizeof(header.Magic));
+    header.Version = kSnapshotVersion;
+    header.ByteOrderMark = kSnapshotByteOrderMark;
+    header.CharSize = sizeof(CharT);
+    header.StringCount = count;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!strings[i].IsEmpty())
+        {
+            header.CharCount += strings[i].Length() + 1;
+        }
+    }
+    return header;
+}
+
+// Total size of a snapshot, in bytes.
+inline uint64_t SnapshotSizeInBytes(const SnapshotHeader& header) noexcept
+{
+    return sizeof(SnapshotHeader) + (header.StringCount * sizeof(SnapshotEntry))
+        + (header.CharCount * header.CharSize);
+}
+
+// Write the snapshot of the 'count' strings to 'sink' 
+// (an object with a Write(const void* data, size_t sizeInBytes) method).
+// 
+// Strings that are contiguous in the pool (e.g. allocated in sequence, like with
+// AllocStrings) are written with a single call, straight from the pool chunks.
+template <typename CharT, typename Sink>
+void WriteSnapshot(Sink& sink, const SnapshotHeader& header, 
+                   const BasicString<CharT>* strings, size_t count)
+{
+    sink.Write(&header, sizeof(header));
+
+    // Write the handle table, in blocks
+    enum { kBlockSize = 1024 };
+    SnapshotEntry block[kBlockSize];
+    size_t blockCount = 0;
+
+    uint64_t offset = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const size_t length = strings[i].Length();
+        block[blockCount].Offset = (length != 0) ? offset : 0;
+        block[blockCount].Length = length;
+        if (length != 0)
+        {
+            offset += length + 1;
+        }
+
+        if (++blockCount == kBlockSize)
+        {
+            sink.Write(block, sizeof(block));
+            blockCount = 0;
+        }
+    }
+    sink.Write(block, blockCount * sizeof(SnapshotEntry));
+
+    // Write the characters, merging the runs of contiguous strings
+    const CharT* runStart = nullptr;
+    const CharT* runFinish = nullptr;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const BasicString<CharT>& s = strings[i];
+        if (s.IsEmpty())
+        {
+            continue;
+        }
+
+        if (s.Str() != runFinish)
+        {
+            sink.Write(runStart, (runFinish - runStart) * sizeof(CharT));
+            runStart = s.Str();
+        }
+        runFinish = s.Str() + s.Length() + 1;
+    }
+    sink.Write(runStart, (runFinish - runStart) * sizeof(CharT));
+}
+
+// Validate the header and the size of the snapshot in the 'sizeInBytes' bytes 
+// pointed by 'data', and return its header.
+// Throws StringPool::SnapshotError if the snapshot is not valid for CharT.
+template <typename CharT>
+SnapshotHeader ReadSnapshotHeader(const uint8_t* data, size_t sizeInBytes)
+{
+    SnapshotHeader header;
+    if (sizeInBytes < sizeof(header))
+    {
+        RaiseSnapshotError("StringPool: invalid snapshot file");
+    }
+    memcpy(&header, data, sizeof(header));
+
+    if (memcmp(header.Magic, kSnapshotMagic, sizeof(header.Magic)) != 0
+        || header.Version != kSnapshotVersion
+        || header.ByteOrderMark != kSnapshotByteOrderMark
+        || header.CharSize != sizeof(CharT))
+    {
+        RaiseSnapshotError("StringPool: invalid snapshot file");
+    }
+
+    // The table and the characters must fill the snapshot exactly
+    // (the division prevents overflows on corrupted counts)
+    const size_t bodyBytes = sizeInBytes - sizeof(header);
+    if (header.StringCount > bodyBytes / sizeof(SnapshotEntry))
+    {
+        RaiseSnapshotError("StringPool: invalid snapshot file");
+    }
+
+    const size_t charBytes = bodyBytes 
+        - static_cast<size_t>(header.StringCount) * sizeof(SnapshotEntry);
+    if (charBytes % sizeof(CharT) != 0 || header.CharCount != charBytes / sizeof(CharT))
+    {
+        RaiseSnapshotError("StringPool: invalid snapshot file");
+    }
+
+    // Bound any C-style read of the strings within the snapshot
+    const CharT* chars = reinterpret_cast<const CharT*>(data + sizeInBytes) 
+        - header.CharCount;
+    if (header.CharCount != 0 && chars[header.CharCount - 1] != CharT())
+    {
+        RaiseSnapshotError("StringPool: invalid snapshot file");
+    }
+
+    return header;
+}
+
+// Check that a string of the table lies within the 'charCount' snapshot characters
+// 'chars', followed by its NUL (so the handles are valid C-style strings, too).
+template <typename CharT>
+inline bool IsValidSnapshotEntry(uint64_t offset, uint64_t length,
+                                 const CharT* chars, uint64_t charCount) noexcept
+{
+    if (length == 0)
+    {
+        return true;
+    }
+
+    return offset < charCount && length < charCount - offset
+        && chars[offset + length] == CharT(0);
+}
+
+} // namespace Detail
+
+
+//----------------------------------------------------------------------------------------
+// Save the 'count' strings to a snapshot file at 'path' (overwritten if existing),
+// to be reloaded with StringPool::BasicSnapshot.
+//
+// Strings that are contiguous in the pool (e.g. allocated in sequence, like with
+// AllocStrings) are written with a single call, straight from the pool chunks.
+// Throws StringPool::SnapshotError on failure
+// (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+//----------------------------------------------------------------------------------------
+template <typename CharT>
+void SaveSnapshot(const char* path, const BasicString<CharT>* strings, size_t count)
+{
+    const Detail::SnapshotHeader header = Detail::MakeSnapshotHeader(strings, count);
+
+    Detail::SnapshotFile file{ path };
+    Detail::WriteSnapshot(file, header, strings, count);
+    file.Close();
+}
+
+// Save the strings to a snapshot file at 'path'.
+template <typename CharT>
+void SaveSnapshot(const char* path, const std::vector<BasicString<CharT>>& strings)
+{
+    SaveSnapshot(path, strings.data(), strings.size());
+}
+
+
+#ifdef STRINGPOOL_HAS_SNAPSHOT
+
+//----------------------------------------------------------------------------------------
+// Snapshot file saved with StringPool::SaveSnapshot, memory-mapped read-only.
+//
+// The String handles returned by Strings() point into the mapped file (there are
+// no character copies), so they are valid as long as this object is alive,
+// like the strings of an allocator.
+//
+// StringPool::Snapshot loads wchar_t strings; note that wchar_t snapshots can't be
+// exchanged between Windows and Linux/macOS, as the character size differs.
+//----------------------------------------------------------------------------------------
+template <typename CharT>
+class BasicSnapshot
+{
+public:
+
+    // The type of the strings in the snapshot
+    typedef BasicString<CharT> String;
+
+    // Creates an empty snapshot, with no strings.
+    BasicSnapshot() = default;
+
+    // Map the snapshot file at 'path', and reconstruct its String handles.
+    // Throws StringPool::SnapshotError if the file can't be mapped, or is not
+    // a valid snapshot for this character type, and std::bad_alloc if the handles
+    // can't be allocated (aborts if STRINGPOOL_NO_EXCEPTIONS is defined).
+    explicit BasicSnapshot(const char* path)
+    {
+        Map(path);
+
+#ifdef STRINGPOOL_NO_EXCEPTIONS
+        Load();
+#else
+        try
+        {
+            Load();
+        }
+        catch (...)
+        {
+            Unmap();
+            throw;
+        }
+#endif
+    }
+
+    // Unmap the file.
+    ~BasicSnapshot()
+    {
+        Unmap();
+    }
+
+    // Ban copy
+    BasicSnapshot(const BasicSnapshot&) = delete;
+    BasicSnapshot& operator=(const BasicSnapshot&) = delete;
+
+    // Move the mapping from the other snapshot, leaving it empty.
+    BasicSnapshot(BasicSnapshot&& other) noexcept
+    {
+        swap(*this, other);
+    }
+
+    // Unmap this snapshot, and move the mapping from the other snapshot,
+    // leaving it empty.
+    BasicSnapshot& operator=(BasicSnapshot&& other) noexcept
+    {
+        if (&other != this)
+        {
+            BasicSnapshot temp{ std::move(other) };
+            swap(*this, temp);
+        }
+        return *this;
+    }
+
+    // STL-style non-throwing swap
+    friend void swap(BasicSnapshot& a, BasicSnapshot& b) noexcept
+    {
+        using std::swap;
+        swap(a.m_pData,       b.m_pData);
+        swap(a.m_sizeInBytes, b.m_sizeInBytes);
+        swap(a.m_strings,     b.m_strings);
+    }
+
+    // The strings of the snapshot, in the saved order.
+    const std::vector<String>& Strings() const noexcept
+    {
+        return m_strings;
+    }
+
+    // Size of the mapped file, in bytes.
+    size_t SizeInBytes() const noexcept
+    {
+        return m_sizeInBytes;
+    }
+
+
+private:
+    const uint8_t* m_pData{};   // The mapped file
+    size_t m_sizeInBytes{};
+    std::vector<String> m_strings{};
+
+    // Validate the mapped file, and build the String handles.
+    void Load()
+    {
+        const Detail::SnapshotHeader header = 
+            Detail::ReadSnapshotHeader<CharT>(m_pData, m_sizeInBytes);
+
+        const auto* table = reinterpret_cast<const Detail::SnapshotEntry*>(
+            m_pData + sizeof(header));
+        const auto* chars = reinterpret_cast<const CharT*>(
+            table + header.StringCount);
+
+        const size_t stringCount = static_cast<size_t>(header.StringCount);
+        m_strings.reserve(stringCount);
+        for (size_t i = 0; i < stringCount; ++i)
+        {
+            const Detail::SnapshotEntry& entry = table[i];
+            if (entry.Length == 0)
+            {
+                m_strings.push_back(String{});
+                continue;
+            }
+
+            if (!Detail::IsValidSnapshotEntry(entry.Offset, entry.Length, chars,
+                                              header.CharCount))
+            {
+                Detail::RaiseSnapshotError("StringPool: invalid snapshot file");
+            }
+
+            m_strings.push_back(String{ chars + entry.Offset,
+                                        static_cast<size_t>(entry.Length) });
+        }
+    }
+
+#if defined(_WIN32)
+
+    // Map the file read-only.
+    void Map(const char* path)
+    {
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            Detail::RaiseSnapshotError("StringPool: can't open the snapshot file");
+        }
+
+        LARGE_INTEGER fileSize{};
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0
+            || static_cast<unsigned long long>(fileSize.QuadPart) > SIZE_MAX)
+        {
+            CloseHandle(file);
+            Detail::RaiseSnapshotError("StringPool: invalid snapshot file");
+        }
+
+        // The view keeps the file mapping alive, so both handles can be closed
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* pView = nullptr;
+        if (mapping != nullptr)
+        {
+            pView = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+
+        if (pView == nullptr)
+        {
+            Detail::RaiseSnapshotError("StringPool: can't map the snapshot file");
+        }
+
+        m_pData = static_cast<const uint8_t*>(pView);
+        m_sizeInBytes = static_cast<size_t>(fileSize.QuadPart);
+    }
+
+    // Unmap the file, if any.
+    void Unmap() noexcept
+    {
+        if (m_pData != nullptr)
+        {
+            UnmapViewOfFile(m_pData);
+            m_pData = nullptr;
+            m_sizeInBytes = 0;
+        }
+        m_strings.clear();
+    }
+
+#else
+
+    // Map the file read-only.
+    void Map(const char* path)
+    {
+        const int file = open(path, O_RDONLY);
+        if (file < 0)
+        {
+            Detail::RaiseSnapshotError("StringPool: can't open the snapshot file");
+        }
+
+        struct stat fileInfo{};
+        if (fstat(file, &fileInfo) != 0 || fileInfo.st_size <= 0
+            || static_cast<unsigned long long>(fileInfo.st_size) > SIZE_MAX)
+        {
+            close(file);
+            Detail::RaiseSnapshotError("StringPool: invalid snapshot file");
+        }
+
+        // The mapping stays valid after closing the file
+        const size_t size = static_cast<size_t>(fileInfo.st_size);
+        void* pView = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        close(file);
+
+        if (pView == MAP_FAILED)
+        {
+            Detail::RaiseSnapshotError("StringPool: can't map the snapshot file");
+        }
+
+        m_pData = static_cast<const uint8_t*>(pView);
+        m_sizeInBytes = size;
+    }
+
+    // Unmap the file, if any.
+    void Unmap() noexcept
+    {
+        if (m_pData != nullptr)
+        {
+            munmap(const_cast<uint8_t*>(m_pData), m_sizeInBytes);
+            m_pData = nullptr;
+            m_sizeInBytes = 0;
+        }
+        m_strings.clear();
+    }
+
+#endif
+};
+
+// Snapshot of wchar_t strings (StringPool::String).
+using Snapshot = BasicSnapshot<wchar_t>;
+
+#endif // STRINGPOOL_HAS_SNAPSHOT
+
+} // namespace StringPool
+
+
+#endif // INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_SNAPSHOT_H
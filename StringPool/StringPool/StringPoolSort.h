@@ -0,0 +1,760 @@
+#ifndef INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_SORT_H
+#define INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_SORT_H
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//
+// String sorting algorithms specialized for vectors of pool-allocated strings
+// (StringPool::String, or StringPool::BasicString of any character type).
+//
+// Copyright (C) by Giovanni Dicanio
+//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include "StringPool.h"
+
+#include <algorithm>    // For std::sort, std::upper_bound
+#include <atomic>       // For std::atomic
+#include <cstddef>      // For ptrdiff_t
+#include <cstdint>      // For int64_t, uint16_t
+#include <iterator>     // For std::iterator_traits
+#include <limits>       // For std::numeric_limits
+#include <thread>       // For std::thread
+#include <utility>      // For std::swap, std::move
+#include <vector>       // For std::vector
+
+
+namespace StringPool
+{
+
+//========================================================================================
+//                          Implementation Details
+//========================================================================================
+
+namespace Detail
+{
+
+// Character key used by the string sorting algorithms: the character at a given 
+// position, or kEndOfString past the end of the string.
+// 64 bits are enough to hold any character value (signed or unsigned),
+// plus an end-of-string marker that compares less than any character.
+typedef int64_t CharKey;
+
+const CharKey kEndOfString = (std::numeric_limits<CharKey>::min)();
+
+// Ranges with no more strings than that are sorted using insertion sort.
+const ptrdiff_t kInsertionSortThreshold = 16;
+
+
+// Character key of a character, in the order of std::char_traits<CharT>::lt
+// (and so of BasicString::Compare): char compares as unsigned char, like memcmp.
+template <typename CharT>
+inline CharKey ToCharKey(CharT ch) noexcept
+{
+    return static_cast<CharKey>(ch);
+}
+
+template <>
+inline CharKey ToCharKey<char>(char ch) noexcept
+{
+    return static_cast<CharKey>(static_cast<unsigned char>(ch));
+}
+
+// Return the character key of the string at the given position.
+template <typename CharT>
+inline CharKey KeyAt(const BasicString<CharT>& s, size_t depth) noexcept
+{
+    return depth < s.Length() ? ToCharKey(s.Str()[depth]) : kEndOfString;
+}
+
+// Compare two strings that share their first 'depth' characters,
+// with the same semantics of BasicString::Compare.
+template <typename CharT>
+inline int CompareFrom(const BasicString<CharT>& a, const BasicString<CharT>& b, 
+                       size_t depth) noexcept
+{
+    const size_t lengthA = a.Length() - depth;
+    const size_t lengthB = b.Length() - depth;
+    const size_t minLength = lengthA < lengthB ? lengthA : lengthB;
+
+    const int result = CompareChars(a.Str() + depth, b.Str() + depth, minLength);
+    if (result != 0)
+        return result;
+
+    if (lengthA < lengthB)
+        return -1;
+
+    if (lengthA > lengthB)
+        return 1;
+
+    return 0;
+}
+
+// Length of the common prefix of two strings, starting the scan at 'depth'.
+template <typename CharT>
+inline size_t CommonPrefixFrom(const BasicString<CharT>& a, const BasicString<CharT>& b, 
+                               size_t depth) noexcept
+{
+    const size_t minLength = a.Length() < b.Length() ? a.Length() : b.Length();
+    const CharT* pa = a.Str();
+    const CharT* pb = b.Str();
+
+    if (depth >= minLength)
+    {
+        return depth;
+    }
+
+    return depth + Mismatch(pa + depth, pb + depth, minLength - depth);
+}
+
+inline CharKey MedianOf3(CharKey a, CharKey b, CharKey c) noexcept
+{
+    if (a < b)
+    {
+        if (b < c)
+            return b;
+
+        return a < c ? c : a;
+    }
+    else
+    {
+        if (a < c)
+            return a;
+
+        return b < c ? c : b;
+    }
+}
+
+// Sort a small range of strings sharing their first 'depth' characters.
+template <typename RandomIt>
+void InsertionSort(RandomIt first, RandomIt last, size_t depth)
+{
+    using std::swap;
+
+    if (first == last)
+    {
+        return;
+    }
+
+    for (RandomIt i = first + 1; i != last; ++i)
+    {
+        for (RandomIt j = i; j != first && CompareFrom(*j, *(j - 1), depth) < 0; --j)
+        {
+            swap(*j, *(j - 1));
+        }
+    }
+}
+
+// Multikey quicksort (Bentley-Sedgewick) of a range of strings sharing
+// their first 'depth' characters.
+//
+// 'budget' limits the recursion on the less/greater partitions: when it's exhausted
+// (pathological pivots), the range is sorted with std::sort, like in introsort.
+template <typename RandomIt>
+void MultikeyQuicksort(RandomIt first, RandomIt last, size_t depth, int budget)
+{
+    using std::swap;
+    typedef typename std::iterator_traits<RandomIt>::value_type StringType;
+
+    while (last - first > kInsertionSortThreshold)
+    {
+        if (budget <= 0)
+        {
+            std::sort(first, last, [depth](const StringType& a, const StringType& b)
+            {
+                return CompareFrom(a, b, depth) < 0;
+            });
+            return;
+        }
+
+        const CharKey pivot = MedianOf3(KeyAt(*first, depth),
+                                        KeyAt(*(first + (last - first) / 2), depth),
+                                        KeyAt(*(last - 1), depth));
+
+        // Three-way partition:
+        // [first, lt) < pivot, [lt, gt) == pivot, [gt, last) > pivot
+        RandomIt lt = first;
+        RandomIt gt = last;
+        RandomIt i = first;
+        while (i != gt)
+        {
+            const CharKey key = KeyAt(*i, depth);
+            if (key < pivot)
+            {
+                swap(*lt, *i);
+                ++lt;
+                ++i;
+            }
+            else if (key > pivot)
+            {
+                --gt;
+                swap(*i, *gt);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+
+        if (lt == first && gt == last)
+        {
+            // All the strings have the same character at this position:
+            // skip their whole common prefix in a single pass
+            if (pivot == kEndOfString)
+            {
+                return;
+            }
+
+            size_t commonPrefix = first->Length();
+            for (RandomIt j = first + 1; j != last; ++j)
+            {
+                const size_t prefix = CommonPrefixFrom(*first, *j, depth + 1);
+                if (prefix < commonPrefix)
+                {
+                    commonPrefix = prefix;
+                }
+            }
+
+            depth = commonPrefix;
+            continue;
+        }
+
+        MultikeyQuicksort(first, lt, depth, budget - 1);
+        MultikeyQuicksort(gt, last, depth, budget - 1);
+
+        // The strings in the middle partition are equal if they all ended here;
+        // else, sort them on the next character
+        if (pivot == kEndOfString)
+        {
+            return;
+        }
+
+        first = lt;
+        last = gt;
+        ++depth;
+    }
+
+    InsertionSort(first, last, depth);
+}
+
+
+// Parallel sort parameters
+enum
+{
+    // Ranges smaller than that are sorted on the calling thread only
+    kParallelSortThreshold = 64 * 1024,
+
+    // Number of buckets of the parallel sample sort.
+    // It doesn't depend on the thread count, so the output is deterministic.
+    kSampleSortBucketCount = 256,
+
+    // Sample elements taken for each bucket, to choose the splitters
+    kSampleSortOversampling = 16
+};
+
+// Invoke func(threadIndex) on threadCount threads, including the calling thread,
+// and wait for all of them to finish.
+template <typename Function>
+void RunInParallel(unsigned int threadCount, Function func)
+{
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+
+#ifndef STRINGPOOL_NO_EXCEPTIONS
+    try
+    {
+#endif
+        for (unsigned int threadIndex = 1; threadIndex < threadCount; ++threadIndex)
+        {
+            threads.emplace_back(func, threadIndex);
+        }
+#ifndef STRINGPOOL_NO_EXCEPTIONS
+    }
+    catch (...)
+    {
+        // Don't leave joinable threads behind
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        throw;
+    }
+#endif
+
+    func(0);
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+
+// Merge two sorted runs a[0, countA) and b[0, countB), using their LCP arrays
+// (lcpX[i] is the length of the longest common prefix of x[i-1] and x[i]) 
+// to skip the characters already known to be equal.
+// 
+// For each merged string in order, invokes emit(string, lcp), where lcp is the LCP
+// of the string with the previously emitted one (0 for the first one).
+// Equal strings from 'a' are emitted before the ones from 'b' (stable merge).
+template <typename StringPtr, typename Emit>
+void LcpMerge(StringPtr a, const size_t* lcpA, size_t countA,
+              StringPtr b, const size_t* lcpB, size_t countB,
+              Emit emit)
+{
+    size_t i = 0;
+    size_t j = 0;
+
+    // LCP of the current a and b strings with the last emitted string
+    size_t lcpWithLastA = 0;
+    size_t lcpWithLastB = 0;
+
+    while (i < countA && j < countB)
+    {
+        if (lcpWithLastA > lcpWithLastB)
+        {
+            // a[i] shares more characters with the last emitted string, so a[i] < b[j]
+            emit(a[i], lcpWithLastA);
+            ++i;
+            lcpWithLastA = i < countA ? lcpA[i] : 0;
+        }
+        else if (lcpWithLastA < lcpWithLastB)
+        {
+            emit(b[j], lcpWithLastB);
+            ++j;
+            lcpWithLastB = j < countB ? lcpB[j] : 0;
+        }
+        else
+        {
+            // Same LCP: compare the characters after the known common prefix
+            const size_t lcp = CommonPrefixFrom(a[i], b[j], lcpWithLastA);
+
+            if (KeyAt(a[i], lcp) <= KeyAt(b[j], lcp))
+            {
+                emit(a[i], lcpWithLastA);
+                ++i;
+                lcpWithLastA = i < countA ? lcpA[i] : 0;
+                lcpWithLastB = lcp;
+            }
+            else
+            {
+                emit(b[j], lcpWithLastB);
+                ++j;
+                lcpWithLastB = j < countB ? lcpB[j] : 0;
+                lcpWithLastA = lcp;
+            }
+        }
+    }
+
+    // Emit the remaining strings of the unfinished run
+    for (; i < countA; ++i)
+    {
+        emit(a[i], lcpWithLastA);
+        lcpWithLastA = i + 1 < countA ? lcpA[i + 1] : 0;
+    }
+
+    for (; j < countB; ++j)
+    {
+        emit(b[j], lcpWithLastB);
+        lcpWithLastB = j + 1 < countB ? lcpB[j + 1] : 0;
+    }
+}
+
+// LCP merge sort of a[0, count).
+// The sorted strings and their LCP array end up in (b, lcpB) if intoB is true,
+// else in (a, lcpA). The other arrays are used as temporary buffers.
+template <typename CharT>
+void LcpMergeSort(BasicString<CharT>* a, size_t* lcpA, BasicString<CharT>* b, size_t* lcpB,
+                  size_t count, bool intoB)
+{
+    if (count <= static_cast<size_t>(kInsertionSortThreshold))
+    {
+        InsertionSort(a, a + count, 0);
+
+        BasicString<CharT>* target = intoB ? b : a;
+        size_t* targetLcp = intoB ? lcpB : lcpA;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (intoB)
+            {
+                b[i] = std::move(a[i]);
+            }
+            targetLcp[i] = i == 0 ? 0 : CommonPrefixFrom(target[i - 1], target[i], 0);
+        }
+        return;
+    }
+
+    // Sort each half into the other buffer, then merge back into the target
+    const size_t half = count / 2;
+    LcpMergeSort(a, lcpA, b, lcpB, half, !intoB);
+    LcpMergeSort(a + half, lcpA + half, b + half, lcpB + half, count - half, !intoB);
+
+    BasicString<CharT>* source = intoB ? a : b;
+    size_t* sourceLcp = intoB ? lcpA : lcpB;
+    BasicString<CharT>* target = intoB ? b : a;
+    size_t* targetLcp = intoB ? lcpB : lcpA;
+
+    size_t k = 0;
+    LcpMerge(source, sourceLcp, half, 
+             source + half, sourceLcp + half, count - half,
+             [&](BasicString<CharT>& s, size_t lcp)
+             {
+                 target[k] = std::move(s);
+                 targetLcp[k] = lcp;
+                 ++k;
+             });
+}
+
+} // namespace Detail
+
+
+//========================================================================================
+//                              Sorting Functions
+//========================================================================================
+
+//----------------------------------------------------------------------------------------
+// Sort a range of StringPool::Strings (or BasicStrings of any character type), 
+// in the same order as operator<.
+//
+// Implements a multikey quicksort (a kind of MSD radix sort) over the string
+// characters: each string character is inspected a few times, instead of running
+// O(n log n) full string comparisons like std::sort does.
+// Small partitions are sorted with insertion sort.
+//----------------------------------------------------------------------------------------
+template <typename RandomIt>
+void Sort(RandomIt first, RandomIt last)
+{
+    int budget = 0;
+    for (auto n = last - first; n > 1; n >>= 1)
+    {
+        budget += 2;
+    }
+
+    Detail::MultikeyQuicksort(first, last, 0, budget);
+}
+
+
+//----------------------------------------------------------------------------------------
+// Sort a range of StringPool::Strings in parallel, in the same order as operator<.
+//
+// Implements a sample sort: splitters are chosen from a regular sample of the input, 
+// the strings are distributed into buckets by parallel threads, and then the buckets
+// are sorted with StringPool::Sort, with the threads picking the next unsorted bucket 
+// (largest first) as they finish.
+//
+// The number of buckets is fixed, so the output is the same for any thread count.
+// Pass threadCount = 0 to use all the hardware threads.
+//----------------------------------------------------------------------------------------
+template <typename RandomIt>
+void ParallelSort(RandomIt first, RandomIt last, unsigned int threadCount = 0)
+{
+    using Detail::RunInParallel;
+    typedef typename std::iterator_traits<RandomIt>::value_type StringType;
+
+    const size_t count = last - first;
+
+    if (threadCount == 0)
+    {
+        threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0)
+        {
+            threadCount = 1;
+        }
+    }
+
+    // Note: even with a single thread, large ranges go through the sample sort below,
+    // so that the order of equal strings doesn't depend on the thread count
+    if (count < Detail::kParallelSortThreshold)
+    {
+        Sort(first, last);
+        return;
+    }
+
+    const size_t kBucketCount = Detail::kSampleSortBucketCount;
+    static_assert(Detail::kSampleSortBucketCount <= 65536, "Bucket index is a uint16_t");
+
+    //
+    // Choose the bucket splitters from a regular sample of the input
+    //
+    const size_t sampleCount = kBucketCount * Detail::kSampleSortOversampling;
+
+    std::vector<StringType> sample;
+    sample.reserve(sampleCount);
+    for (size_t i = 0; i < sampleCount; ++i)
+    {
+        sample.push_back(first[i * count / sampleCount]);
+    }
+    Sort(sample.begin(), sample.end());
+
+    std::vector<StringType> splitters;
+    splitters.reserve(kBucketCount - 1);
+    for (size_t bucket = 1; bucket < kBucketCount; ++bucket)
+    {
+        splitters.push_back(sample[bucket * Detail::kSampleSortOversampling]);
+    }
+
+    // Each thread works on a contiguous slice of the input
+    const auto sliceStart = [count, threadCount](unsigned int threadIndex)
+    {
+        return threadIndex * count / threadCount;
+    };
+
+    //
+    // Find the bucket of each string, counting the bucket sizes for each slice
+    //
+    std::vector<uint16_t> bucketOf(count);
+    std::vector<size_t> offsets(threadCount * kBucketCount);
+
+    RunInParallel(threadCount, [&](unsigned int threadIndex)
+    {
+        size_t* sliceCounts = &offsets[threadIndex * kBucketCount];
+
+        const size_t finish = sliceStart(threadIndex + 1);
+        for (size_t i = sliceStart(threadIndex); i < finish; ++i)
+        {
+            const size_t bucket = std::upper_bound(splitters.begin(), splitters.end(), 
+                                                   first[i]) - splitters.begin();
+            bucketOf[i] = static_cast<uint16_t>(bucket);
+            ++sliceCounts[bucket];
+        }
+    });
+
+    // Turn the counts into the scatter offsets of each slice into each bucket;
+    // within a bucket, the strings keep their input order
+    std::vector<size_t> bucketStart(kBucketCount + 1);
+    size_t offset = 0;
+    for (size_t bucket = 0; bucket < kBucketCount; ++bucket)
+    {
+        bucketStart[bucket] = offset;
+        for (unsigned int threadIndex = 0; threadIndex < threadCount; ++threadIndex)
+        {
+            const size_t sliceCount = offsets[threadIndex * kBucketCount + bucket];
+            offsets[threadIndex * kBucketCount + bucket] = offset;
+            offset += sliceCount;
+        }
+    }
+    bucketStart[kBucketCount] = offset;
+
+    //
+    // Distribute the strings into the buckets
+    //
+    std::vector<StringType> buffer(count);
+
+    RunInParallel(threadCount, [&](unsigned int threadIndex)
+    {
+        size_t* sliceOffsets = &offsets[threadIndex * kBucketCount];
+
+        const size_t finish = sliceStart(threadIndex + 1);
+        for (size_t i = sliceStart(threadIndex); i < finish; ++i)
+        {
+            buffer[sliceOffsets[bucketOf[i]]++] = std::move(first[i]);
+        }
+    });
+
+    //
+    // Sort the buckets, largest first, for better load balancing
+    //
+    std::vector<uint16_t> bucketOrder(kBucketCount);
+    for (size_t bucket = 0; bucket < kBucketCount; ++bucket)
+    {
+        bucketOrder[bucket] = static_cast<uint16_t>(bucket);
+    }
+    std::sort(bucketOrder.begin(), bucketOrder.end(), [&](uint16_t a, uint16_t b)
+    {
+        return (bucketStart[a + 1] - bucketStart[a]) > (bucketStart[b + 1] - bucketStart[b]);
+    });
+
+    std::atomic<size_t> nextBucket{ 0 };
+
+    RunInParallel(threadCount, [&](unsigned int /* threadIndex */)
+    {
+        for (;;)
+        {
+            const size_t next = nextBucket++;
+            if (next >= kBucketCount)
+            {
+                break;
+            }
+
+            const size_t bucket = bucketOrder[next];
+            Sort(buffer.begin() + bucketStart[bucket], buffer.begin() + bucketStart[bucket + 1]);
+        }
+    });
+
+    //
+    // Move the sorted strings back
+    //
+    RunInParallel(threadCount, [&](unsigned int threadIndex)
+    {
+        const size_t finish = sliceStart(threadIndex + 1);
+        for (size_t i = sliceStart(threadIndex); i < finish; ++i)
+        {
+            first[i] = std::move(buffer[i]);
+        }
+    });
+}
+
+
+//========================================================================================
+//                      LCP-Aware Merging and Sorting
+//========================================================================================
+
+//----------------------------------------------------------------------------------------
+// Compute the LCP array of a sorted range of strings: 
+// lcps[i] is the length of the longest common prefix of the strings i-1 and i,
+// and lcps[0] is 0.
+//----------------------------------------------------------------------------------------
+template <typename RandomIt>
+void ComputeLcpArray(RandomIt first, RandomIt last, std::vector<size_t>& lcps)
+{
+    const size_t count = last - first;
+    lcps.resize(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        lcps[i] = i == 0 ? 0 : Detail::CommonPrefixFrom(first[i - 1], first[i], 0);
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Merge two sorted runs of strings, with their LCP arrays (see ComputeLcpArray).
+// 
+// The LCP values let the merge skip the characters already known to be equal, so 
+// each character is inspected at most once, instead of rescanning the shared
+// prefixes at each comparison.
+// The merged strings are appended to 'result', and their LCP array to 'lcpResult'.
+//----------------------------------------------------------------------------------------
+template <typename CharT>
+void LcpMerge(const std::vector<BasicString<CharT>>& a, const std::vector<size_t>& lcpA,
+              const std::vector<BasicString<CharT>>& b, const std::vector<size_t>& lcpB,
+              std::vector<BasicString<CharT>>& result, std::vector<size_t>& lcpResult)
+{
+    result.reserve(result.size() + a.size() + b.size());
+    lcpResult.reserve(lcpResult.size() + a.size() + b.size());
+
+    // The first merged string must be compared with the current last result, if any
+    const size_t firstIndex = result.size();
+
+    Detail::LcpMerge(a.data(), lcpA.data(), a.size(), 
+                     b.data(), lcpB.data(), b.size(),
+                     [&](const BasicString<CharT>& s, size_t lcp)
+                     {
+                         result.push_back(s);
+                         lcpResult.push_back(lcp);
+                     });
+
+    if (firstIndex > 0 && firstIndex < result.size())
+    {
+        lcpResult[firstIndex] = Detail::CommonPrefixFrom(
+            result[firstIndex - 1], result[firstIndex], 0);
+    }
+}
+
+//----------------------------------------------------------------------------------------
+// Merge several sorted runs of strings (e.g. coming from different shards), 
+// with their LCP arrays (e.g. as returned by LcpMergeSort), into 'result', 
+// storing the LCP array of the merged strings into 'lcpResult'.
+// 
+// The runs are merged pairwise with LcpMerge, in a balanced tree of merges.
+//----------------------------------------------------------------------------------------
+template <typename CharT>
+void MergeSortedRuns(const std::vector<std::vector<BasicString<CharT>>>& runs,
+                     const std::vector<std::vector<size_t>>& runLcps,
+                     std::vector<BasicString<CharT>>& result, std::vector<size_t>& lcpResult)
+{
+    typedef std::vector<BasicString<CharT>> Run;
+
+    result.clear();
+    lcpResult.clear();
+
+    if (runs.empty())
+    {
+        return;
+    }
+
+    // Merge adjacent pairs of runs; an odd run out is just copied
+    const auto mergeRound = [](const std::vector<Run>& in,
+                               const std::vector<std::vector<size_t>>& inLcps,
+                               std::vector<Run>& out,
+                               std::vector<std::vector<size_t>>& outLcps)
+    {
+        out.clear();
+        outLcps.clear();
+        out.resize((in.size() + 1) / 2);
+        outLcps.resize((in.size() + 1) / 2);
+
+        for (size_t i = 0; i + 1 < in.size(); i += 2)
+        {
+            LcpMerge(in[i], inLcps[i], in[i + 1], inLcps[i + 1], 
+                     out[i / 2], outLcps[i / 2]);
+        }
+
+        if (in.size() % 2 != 0)
+        {
+            out.back() = Run(in.back());
+            outLcps.back() = inLcps.back();
+        }
+    };
+
+    // The first round reads the input runs, the following ones the merged runs
+    std::vector<Run> current;
+    std::vector<std::vector<size_t>> currentLcps;
+    mergeRound(runs, runLcps, current, currentLcps);
+
+    std::vector<Run> next;
+    std::vector<std::vector<size_t>> nextLcps;
+    while (current.size() > 1)
+    {
+        mergeRound(current, currentLcps, next, nextLcps);
+        current.swap(next);
+        currentLcps.swap(nextLcps);
+    }
+
+    result.swap(current[0]);
+    lcpResult.swap(currentLcps[0]);
+}
+
+//----------------------------------------------------------------------------------------
+// Merge several sorted runs of strings, first computing their LCP arrays.
+//----------------------------------------------------------------------------------------
+template <typename CharT>
+void MergeSortedRuns(const std::vector<std::vector<BasicString<CharT>>>& runs,
+                     std::vector<BasicString<CharT>>& result, std::vector<size_t>& lcpResult)
+{
+    std::vector<std::vector<size_t>> runLcps(runs.size());
+    for (size_t i = 0; i < runs.size(); ++i)
+    {
+        ComputeLcpArray(runs[i].begin(), runs[i].end(), runLcps[i]);
+    }
+
+    MergeSortedRuns(runs, runLcps, result, lcpResult);
+}
+
+//----------------------------------------------------------------------------------------
+// Sort the strings with an LCP merge sort, and return their LCP array in 'lcps'
+// (lcps[i] is the length of the longest common prefix of strings[i-1] and strings[i]).
+// The sort is stable.
+//----------------------------------------------------------------------------------------
+template <typename CharT>
+void LcpMergeSort(std::vector<BasicString<CharT>>& strings, std::vector<size_t>& lcps)
+{
+    const size_t count = strings.size();
+    lcps.resize(count);
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    std::vector<BasicString<CharT>> buffer(count);
+    std::vector<size_t> bufferLcps(count);
+
+    Detail::LcpMergeSort(strings.data(), lcps.data(), buffer.data(), bufferLcps.data(),
+                         count, false);
+}
+
+
+} // namespace StringPool
+
+
+#endif // INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_SORT_H
@@ -0,0 +1,416 @@
+#ifndef INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_UTF8_H
+#define INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_UTF8_H
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//
+// UTF-8 transcoding kernels used by the string pool
+// (BasicAllocator::AllocStringFromUtf8 and StringPool::ToUtf8).
+//
+// The kernels convert between UTF-8 and the pool character types: UTF-16 for 2-byte
+// characters (char16_t, and wchar_t on Windows), UTF-32 for 4-byte characters
+// (char32_t, and wchar_t on Linux and macOS); 1-byte characters hold UTF-8 as is.
+//
+// Runs of ASCII characters (the common case) are converted 16 at a time with SSE2,
+// when available (see StringPoolSimd.h); the other characters are converted
+// one code point at a time.
+//
+// Copyright (C) by Giovanni Dicanio
+//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+
+#include <cstddef>      // For size_t
+#include <cstdint>      // For uint8_t, uint16_t, uint32_t
+#include <cstring>      // For memcpy
+#include <type_traits>  // For std::integral_constant
+
+#include "StringPoolSimd.h"
+
+
+namespace StringPool
+{
+namespace Detail
+{
+
+// Returned by TranscodeFromUtf8 for invalid UTF-8 input
+const size_t kInvalidUtf8 = static_cast<size_t>(-1);
+
+// The Unicode replacement character, exported in place of unpaired surrogates
+const char32_t kReplacementChar = 0xFFFD;
+
+// Tag selecting the encoding by character size: 1 (UTF-8), 2 (UTF-16) or 4 (UTF-32)
+template <typename CharT>
+using EncodingOf = std::integral_constant<size_t, sizeof(CharT)>;
+
+
+//----------------------------------------------------------------------------------------
+// Code point decoding and encoding
+//----------------------------------------------------------------------------------------
+
+// Decode the non-ASCII UTF-8 sequence starting at p (p < end).
+// Returns the sequence length in bytes, storing the decoded code point in 'codePoint',
+// or 0 if the sequence is invalid (overlong, truncated, surrogate, or out of range).
+inline size_t DecodeUtf8(const uint8_t* p, const uint8_t* end, char32_t& codePoint) noexcept
+{
+    const uint8_t lead = p[0];
+
+    size_t size;
+    char32_t cp;
+    char32_t minCodePoint;
+    if (lead < 0xC2)
+    {
+        // Continuation byte, or overlong 2-byte sequence
+        return 0;
+    }
+    else if (lead < 0xE0)
+    {
+        size = 2;
+        cp = lead & 0x1F;
+        minCodePoint = 0x80;
+    }
+    else if (lead < 0xF0)
+    {
+        size = 3;
+        cp = lead & 0x0F;
+        minCodePoint = 0x800;
+    }
+    else if (lead < 0xF5)
+    {
+        size = 4;
+        cp = lead & 0x07;
+        minCodePoint = 0x10000;
+    }
+    else
+    {
+        return 0;
+    }
+
+    if (static_cast<size_t>(end - p) < size)
+    {
+        return 0;
+    }
+
+    for (size_t i = 1; i < size; ++i)
+    {
+        if ((p[i] & 0xC0) != 0x80)
+        {
+            return 0;
+        }
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+
+    if (cp < minCodePoint || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+    {
+        return 0;
+    }
+
+    codePoint = cp;
+    return size;
+}
+
+// Encode a code point as UTF-8, returning the end of the written bytes.
+inline uint8_t* EncodeUtf8(char32_t cp, uint8_t* out) noexcept
+{
+    if (cp < 0x80)
+    {
+        *out++ = static_cast<uint8_t>(cp);
+    }
+    else if (cp < 0x800)
+    {
+        *out++ = static_cast<uint8_t>(0xC0 | (cp >> 6));
+        *out++ = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000)
+    {
+        *out++ = static_cast<uint8_t>(0xE0 | (cp >> 12));
+        *out++ = static_cast<uint8_t>(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+    }
+    else
+    {
+        *out++ = static_cast<uint8_t>(0xF0 | (cp >> 18));
+        *out++ = static_cast<uint8_t>(0x80 | ((cp >> 12) & 0x3F));
+        *out++ = static_cast<uint8_t>(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = static_cast<uint8_t>(0x80 | (cp & 0x3F));
+    }
+    return out;
+}
+
+// Write a validated non-ASCII code point, decoded from the UTF-8 bytes [p, p + size),
+// in the target encoding; returns the end of the written characters.
+template <typename CharT>
+CharT* EncodeCodePoint(char32_t /* cp */, const uint8_t* p, size_t size, CharT* out,
+                       std::integral_constant<size_t, 1>) noexcept
+{
+    // UTF-8 to UTF-8: just copy the validated bytes
+    memcpy(out, p, size);
+    return out + size;
+}
+
+template <typename CharT>
+CharT* EncodeCodePoint(char32_t cp, const uint8_t* /* p */, size_t /* size */, CharT* out,
+                       std::integral_constant<size_t, 2>) noexcept
+{
+    if (cp < 0x10000)
+    {
+        *out++ = static_cast<CharT>(cp);
+    }
+    else
+    {
+        // Surrogate pair
+        cp -= 0x10000;
+        *out++ = static_cast<CharT>(0xD800 + (cp >> 10));
+        *out++ = static_cast<CharT>(0xDC00 + (cp & 0x3FF));
+    }
+    return out;
+}
+
+template <typename CharT>
+CharT* EncodeCodePoint(char32_t cp, const uint8_t* /* p */, size_t /* size */, CharT* out,
+                       std::integral_constant<size_t, 4>) noexcept
+{
+    *out++ = static_cast<CharT>(cp);
+    return out;
+}
+
+// Decode the code point starting at s[i] (i < length) in the source encoding,
+// advancing 'i' past it. Invalid input is decoded as the replacement character.
+template <typename CharT>
+char32_t DecodeCodePoint(const CharT* s, size_t length, size_t& i,
+                         std::integral_constant<size_t, 2>) noexcept
+{
+    const char32_t unit = static_cast<uint16_t>(s[i++]);
+    if (unit < 0xD800 || unit > 0xDFFF)
+    {
+        return unit;
+    }
+
+    // Surrogate pair: a high surrogate followed by a low one
+    if (unit <= 0xDBFF && i < length)
+    {
+        const char32_t low = static_cast<uint16_t>(s[i]);
+        if (low >= 0xDC00 && low <= 0xDFFF)
+        {
+            ++i;
+            return 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+        }
+    }
+
+    return kReplacementChar;
+}
+
+template <typename CharT>
+char32_t DecodeCodePoint(const CharT* s, size_t /* length */, size_t& i,
+                         std::integral_constant<size_t, 4>) noexcept
+{
+    const char32_t cp = static_cast<uint32_t>(s[i++]);
+    if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+    {
+        return kReplacementChar;
+    }
+    return cp;
+}
+
+
+//----------------------------------------------------------------------------------------
+// ASCII fast paths
+//----------------------------------------------------------------------------------------
+
+#ifdef STRINGPOOL_HAS_SSE2
+
+// Store 16 ASCII bytes as 16 characters of the target encoding.
+template <typename CharT>
+void StoreAscii(__m128i bytes, CharT* out, std::integral_constant<size_t, 1>) noexcept
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), bytes);
+}
+
+template <typename CharT>
+void StoreAscii(__m128i bytes, CharT* out, std::integral_constant<size_t, 2>) noexcept
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i* dest = reinterpret_cast<__m128i*>(out);
+    _mm_storeu_si128(dest,     _mm_unpacklo_epi8(bytes, zero));
+    _mm_storeu_si128(dest + 1, _mm_unpackhi_epi8(bytes, zero));
+}
+
+template <typename CharT>
+void StoreAscii(__m128i bytes, CharT* out, std::integral_constant<size_t, 4>) noexcept
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+    __m128i* dest = reinterpret_cast<__m128i*>(out);
+    _mm_storeu_si128(dest,     _mm_unpacklo_epi16(low, zero));
+    _mm_storeu_si128(dest + 1, _mm_unpackhi_epi16(low, zero));
+    _mm_storeu_si128(dest + 2, _mm_unpacklo_epi16(high, zero));
+    _mm_storeu_si128(dest + 3, _mm_unpackhi_epi16(high, zero));
+}
+
+// Load 16 characters, and pack them into 16 bytes if they're all ASCII.
+// Returns false if some character is not ASCII.
+template <typename CharT>
+bool LoadAscii(const CharT* s, __m128i& bytes, std::integral_constant<size_t, 1>) noexcept
+{
+    bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+    return _mm_movemask_epi8(bytes) == 0;
+}
+
+template <typename CharT>
+bool LoadAscii(const CharT* s, __m128i& bytes, std::integral_constant<size_t, 2>) noexcept
+{
+    const __m128i* src = reinterpret_cast<const __m128i*>(s);
+    const __m128i v0 = _mm_loadu_si128(src);
+    const __m128i v1 = _mm_loadu_si128(src + 1);
+
+    const __m128i nonAscii = _mm_and_si128(_mm_or_si128(v0, v1),
+                                           _mm_set1_epi16(static_cast<short>(0xFF80)));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(nonAscii, _mm_setzero_si128())) != 0xFFFF)
+    {
+        return false;
+    }
+
+    bytes = _mm_packus_epi16(v0, v1);
+    return true;
+}
+
+template <typename CharT>
+bool LoadAscii(const CharT* s, __m128i& bytes, std::integral_constant<size_t, 4>) noexcept
+{
+    const __m128i* src = reinterpret_cast<const __m128i*>(s);
+    const __m128i v0 = _mm_loadu_si128(src);
+    const __m128i v1 = _mm_loadu_si128(src + 1);
+    const __m128i v2 = _mm_loadu_si128(src + 2);
+    const __m128i v3 = _mm_loadu_si128(src + 3);
+
+    const __m128i nonAscii = _mm_and_si128(
+        _mm_or_si128(_mm_or_si128(v0, v1), _mm_or_si128(v2, v3)),
+        _mm_set1_epi32(static_cast<int>(0xFFFFFF80)));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(nonAscii, _mm_setzero_si128())) != 0xFFFF)
+    {
+        return false;
+    }
+
+    bytes = _mm_packus_epi16(_mm_packs_epi32(v0, v1), _mm_packs_epi32(v2, v3));
+    return true;
+}
+
+#endif // STRINGPOOL_HAS_SSE2
+
+
+//----------------------------------------------------------------------------------------
+// Transcoding functions
+//----------------------------------------------------------------------------------------
+
+// Transcode the UTF-8 bytes [source, source + length) into 'dest', in the encoding
+// of CharT (see EncodingOf).
+// 'dest' must have room for 'length' characters: no encoding takes more characters
+// than UTF-8 bytes for the same code point.
+// Returns the number of characters written, or kInvalidUtf8 if the source
+// is not valid UTF-8.
+template <typename CharT>
+size_t TranscodeFromUtf8(const char* source, size_t length, CharT* dest) noexcept
+{
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(source);
+    const uint8_t* const end = p + length;
+    CharT* out = dest;
+
+    while (p != end)
+    {
+#ifdef STRINGPOOL_HAS_SSE2
+        // Convert ASCII runs 16 bytes at a time
+        while (end - p >= 16)
+        {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            if (_mm_movemask_epi8(bytes) != 0)
+            {
+                break;
+            }
+
+            StoreAscii(bytes, out, EncodingOf<CharT>{});
+            p += 16;
+            out += 16;
+        }
+
+        if (p == end)
+        {
+            break;
+        }
+#endif
+
+        if (*p < 0x80)
+        {
+            *out++ = static_cast<CharT>(*p++);
+            continue;
+        }
+
+        char32_t cp;
+        const size_t size = DecodeUtf8(p, end, cp);
+        if (size == 0)
+        {
+            return kInvalidUtf8;
+        }
+
+        out = EncodeCodePoint(cp, p, size, out, EncodingOf<CharT>{});
+        p += size;
+    }
+
+    return out - dest;
+}
+
+// Maximum number of UTF-8 bytes for a string of 'length' characters of type CharT.
+template <typename CharT>
+size_t MaxUtf8Length(size_t length) noexcept
+{
+    // A UTF-16 code unit takes up to 3 UTF-8 bytes (a surrogate pair takes 4),
+    // and a UTF-32 one up to 4
+    return length * (sizeof(CharT) == 1 ? 1 : (sizeof(CharT) == 2 ? 3 : 4));
+}
+
+// Transcode the characters s[0, length) to UTF-8 into 'dest', which must have room
+// for MaxUtf8Length(length) bytes.
+// Returns the number of bytes written.
+template <typename CharT>
+size_t TranscodeToUtf8(const CharT* s, size_t length, char* dest,
+                       std::integral_constant<size_t, 1>) noexcept
+{
+    memcpy(dest, s, length);
+    return length;
+}
+
+template <typename CharT, size_t CharSize>
+size_t TranscodeToUtf8(const CharT* s, size_t length, char* dest,
+                       std::integral_constant<size_t, CharSize> encoding) noexcept
+{
+    uint8_t* out = reinterpret_cast<uint8_t*>(dest);
+    size_t i = 0;
+
+    while (i < length)
+    {
+#ifdef STRINGPOOL_HAS_SSE2
+        // Convert ASCII runs 16 characters at a time
+        __m128i bytes;
+        while (length - i >= 16 && LoadAscii(s + i, bytes, encoding))
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), bytes);
+            i += 16;
+            out += 16;
+        }
+
+        if (i == length)
+        {
+            break;
+        }
+#endif
+
+        out = EncodeUtf8(DecodeCodePoint(s, length, i, encoding), out);
+    }
+
+    return out - reinterpret_cast<uint8_t*>(dest);
+}
+
+} // namespace Detail
+} // namespace StringPool
+
+
+#endif // INCLUDE_GIOVANNI_DICANIO_STRINGPOOL_UTF8_H
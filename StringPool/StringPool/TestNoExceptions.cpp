@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+//
+// Compile check of the String Pool Allocator in builds without exceptions.
+//
+// This file is compiled with exceptions disabled (e.g. /EHs-c- with MSVC,
+// or -fno-exceptions with GCC and Clang), and STRINGPOOL_NO_EXCEPTIONS defined:
+// the non-throwing allocation functions must be usable in such builds.
+//
+// The allocator is instantiated with an instrumentation policy local to this file,
+// so its code doesn't clash with the allocators of TestStringPool.cpp, built
+// with exceptions.
+//
+// by Giovanni Dicanio
+//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+#include "StringPool.h"
+
+#ifndef STRINGPOOL_NO_EXCEPTIONS
+#error "This file must be compiled with STRINGPOOL_NO_EXCEPTIONS defined."
+#endif
+
+#include <cwchar>    // For wcscmp
+
+
+namespace
+{
+
+struct NoExceptionsInstrumentation : StringPool::NoInstrumentation
+{
+};
+
+typedef StringPool::BasicAllocator<wchar_t, NoExceptionsInstrumentation>
+    NoExceptionsAllocator;
+
+} // namespace
+
+
+// Exercise the non-throwing allocation functions.
+// Returns false if any of them doesn't behave as expected.
+bool CheckNoExceptionsAllocation()
+{
+    NoExceptionsAllocator poolAlloc;
+
+    const auto result = poolAlloc.TryAllocString(L"Connie");
+    if (!result || wcscmp(result.Value().Str(), L"Connie") != 0)
+    {
+        return false;
+    }
+
+    if (poolAlloc.TryReserve(static_cast<size_t>(-1) / 2, 1)
+        != StringPool::AllocError::OutOfMemory)
+    {
+        return false;
+    }
+
+    const auto folded = poolAlloc.TryAllocStringFolded(L"ABC", L"ABC" + 3);
+    if (!folded || wcscmp(folded.Value().Str(), L"abc") != 0)
+    {
+        return false;
+    }
+
+    const char utf8[] = "\xC3\xA8";
+    const auto transcoded = poolAlloc.TryAllocStringFromUtf8(utf8, utf8 + 2);
+    if (!transcoded || wcscmp(transcoded.Value().Str(), L"\u00E8") != 0)
+    {
+        return false;
+    }
+
+    poolAlloc.SetBudget(0, poolAlloc.AllocatedBytes());
+    if (poolAlloc.TryReserve(1000 * 1000, 1) != StringPool::AllocError::BudgetExceeded)
+    {
+        return false;
+    }
+
+    return wcscmp(result.Value().Str(), L"Connie") == 0;
+}
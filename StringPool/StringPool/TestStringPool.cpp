@@ -1,282 +1,2662 @@
-//////////////////////////////////////////////////////////////////////////////////////////
-//
-// Benchmarking the String Pool Allocator.
-// 
-// Compares allocating string vectors and sorting them with 
-// std::wstring vs. pool-allocated strings (StringPool).
-// 
-// by Giovanni Dicanio
-// 
-//////////////////////////////////////////////////////////////////////////////////////////
-
-#include "StringPool.h"
-
-#include <algorithm>
-#include <chrono>
-#include <exception>
-#include <iostream>
-#include <random>
-#include <stdexcept>
-#include <string>
-#include <vector>
-using namespace std;
-
-
-//========================================================================================
-//                          Benchmark Infrastructure Code
-//========================================================================================
-
-class Stopwatch
-{
-public:
-    Stopwatch() = default;
-
-    void Start()
-    {
-        m_start = std::chrono::high_resolution_clock::now();
-    }
-
-    void Stop()
-    {
-        TimePoint finish = std::chrono::high_resolution_clock::now();
-        m_elapsed = finish - m_start;
-    }
-
-    void PrintTime(const char* s)
-    {
-        std::cout << s << ": " << (m_elapsed.count() * 1000.0) << " ms\n";
-    }
-
-private:
-    typedef std::chrono::time_point<std::chrono::high_resolution_clock> TimePoint;
-
-    TimePoint m_start{};
-    std::chrono::duration<double> m_elapsed{};
-};
-
-
-inline void PrintTestConditions() 
-{
-    cout << "(";
-#if defined(_M_X64)
-    cout << "64-bit";
-#elif defined(_M_IX86)
-    cout << "32-bit";
-#endif
-
-#ifdef TEST_SSO
-    cout << "; testing with small strings)";
-#else
-    cout << ")";
-#endif
-
-    cout << "\n\n";
-}
-
-
-//========================================================================================
-//                              Main Benchmark Code
-//========================================================================================
-
-void Benchmark()
-{
-    //------------------------------------------------------------------------------------
-    // Build the test strings
-    //------------------------------------------------------------------------------------
-
-    cout << "Building the string vectors for testing...\n\n";
-    const auto shuffled = []() -> vector<wstring>
-    {
-        const wstring lorem[] = {
-            L"Lorem ipsum dolor sit amet, consectetuer adipiscing elit.",
-            L"Maecenas porttitor congue massa. Fusce posuere, magna sed",
-            L"pulvinar ultricies, purus lectus malesuada libero,",
-            L"sit amet commodo magna eros quis urna.",
-            L"Nunc viverra imperdiet enim. Fusce est. Vivamus a tellus.",
-            L"Pellentesque habitant morbi tristique senectus et netus et",
-            L"malesuada fames ac turpis egestas. Proin pharetra nonummy pede.",
-            L"Mauris et orci. [*** add more chars to prevent SSO ***]"
-        };
-
-        vector<wstring> v;
-
-#ifdef _DEBUG
-        const int kCount = 2;
-#else
-        const int kCount = 200 * 1000;
-#endif
-        for (int i = 0; i < kCount; ++i)
-        {
-            for (auto& s : lorem)
-            {
-
-// 
-// Define TEST_SSO to test with the Small String Optimization
-// 
-
-//#define TEST_SSO
-#ifdef TEST_SSO
-                UNREFERENCED_PARAMETER(s);
-                v.push_back(L"#" + to_wstring(i));
-#else
-                v.push_back(s + L" (#" + to_wstring(i) + L")");
-#endif
-            }
-        }
-
-        mt19937 prng(1729);
-
-        shuffle(v.begin(), v.end(), prng);
-
-        return v;
-    }();
-
-    const auto shuffled_ptrs = [&]() -> vector<const wchar_t *> {
-        vector<const wchar_t *> v;
-
-        for (auto& s : shuffled) {
-            v.push_back(s.c_str());
-        }
-
-        return v;
-    }();
-
-
-    //------------------------------------------------------------------------------------
-    // Benchmark Building the String Vectors 
-    //------------------------------------------------------------------------------------
-
-    Stopwatch sw;
-
-    sw.Start();
-    vector<wstring> stl1 = shuffled;
-    sw.Stop();
-    sw.PrintTime("Alloc STL1 ");
-
-    sw.Start();
-    StringPool::Allocator poolAlloc1;
-    vector<StringPool::String> pool1;
-    pool1.reserve(shuffled_ptrs.size());
-    for (const auto& s : shuffled_ptrs)
-    {
-        pool1.push_back(poolAlloc1.AllocString(s));
-    }
-    sw.Stop();
-    sw.PrintTime("Alloc Pool1");
-
-
-#define SANITY_CHECK_ON_STRING_VECTOR_CONTENT
-#ifdef SANITY_CHECK_ON_STRING_VECTOR_CONTENT
-    if (pool1.size() != stl1.size())
-    {
-        throw runtime_error("String vectors have different sizes.");
-    }
-
-    const size_t stringCount = stl1.size();
-    for (size_t i = 0; i < stringCount; i++)
-    {
-        if (wstring(pool1[i].Str(), pool1[i].Length()) != stl1[i])
-        {
-            throw runtime_error("Mismatch between STL string and pool-allocated string.");
-        }
-    }
-#endif
-
-    sw.Start();
-    vector<wstring> stl2 = shuffled;
-    sw.Stop();
-    sw.PrintTime("Alloc STL2 ");
-
-    sw.Start();
-    StringPool::Allocator poolAlloc2;
-    vector<StringPool::String> pool2;
-    pool2.reserve(shuffled_ptrs.size());
-    for (const auto& s : shuffled_ptrs)
-    {
-        pool2.push_back(poolAlloc2.AllocString(s));
-    }
-    sw.Stop();
-    sw.PrintTime("Alloc Pool2");
-
-
-    sw.Start();
-    vector<wstring> stl3 = shuffled;
-    sw.Stop();
-    sw.PrintTime("Alloc STL3 ");
-
-    sw.Start();
-    StringPool::Allocator poolAlloc3;
-    vector<StringPool::String> pool3;
-    pool3.reserve(shuffled_ptrs.size());
-    for (const auto& s : shuffled_ptrs)
-    {
-        pool3.push_back(poolAlloc3.AllocString(s));
-    }
-    sw.Stop();
-    sw.PrintTime("Alloc Pool3");
-
-
-    //------------------------------------------------------------------------------------
-    // Benchmark String Vector Sorting
-    //------------------------------------------------------------------------------------
-
-    cout << "\nSorting...\n\n";
-
-    sw.Start();
-    sort(stl1.begin(), stl1.end());
-    sw.Stop();
-    sw.PrintTime("STL1 ");
-
-    sw.Start();
-    sort(pool1.begin(), pool1.end());
-    sw.Stop();
-    sw.PrintTime("Pool1");
-
-    cout << "\n";
-
-    sw.Start();
-    sort(stl2.begin(), stl2.end());
-    sw.Stop();
-    sw.PrintTime("STL2 ");
-
-    sw.Start();
-    sort(pool2.begin(), pool2.end());
-    sw.Stop();
-    sw.PrintTime("Pool2");
-
-    cout << "\n";
-
-    sw.Start();
-    sort(stl3.begin(), stl3.end());
-    sw.Stop();
-    sw.PrintTime("STL3 ");
-
-    sw.Start();
-    sort(pool3.begin(), pool3.end());
-    sw.Stop();
-    sw.PrintTime("Pool3");
-}
-
-int main() 
-{
-    cout << "*** Testing String Performance (STL vs. Pool) ***\n\n";
-    cout << "by Giovanni Dicanio\n\n";
-
-    PrintTestConditions();
-
-    constexpr int kExitOk = 0;
-    constexpr int kExitError = 1;
-
-    try
-    {
-        Benchmark();
-    }
-    catch (const exception& e)
-    {
-        cout << "\n\n*** ERROR: " << e.what() << "\n\n";
-        return kExitError;
-    }
-
-    return kExitOk;
-}
-
+//////////////////////////////////////////////////////////////////////////////////////////
+//
+// Benchmarking the String Pool Allocator.
+// 
+// Compares allocating string vectors and sorting them with 
+// std::wstring vs. pool-allocated strings (StringPool).
+// 
+// by Giovanni Dicanio
+// 
+//////////////////////////////////////////////////////////////////////////////////////////
+
+#include "StringPool.h"
+#include "StringPoolArt.h"
+#include "StringPoolCompression.h"
+#include "StringPoolDictionary.h"
+#include "StringPoolHashMap.h"
+#include "StringPoolPmr.h"
+#include "StringPoolReader.h"
+#include "StringPoolShared.h"
+#include "StringPoolSnapshot.h"
+#include "StringPoolSort.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cwctype>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Compare with the C++17 parallel std::sort, where available.
+// MSVC ships it in its standard library; with libstdc++, it's built on Intel TBB,
+// so it's compiled only if USE_PARALLEL_STL is defined (and -ltbb is linked).
+#if (defined(_MSVC_LANG) ? _MSVC_LANG : __cplusplus) >= 201703L \
+    && (defined(_MSC_VER) || defined(USE_PARALLEL_STL))
+#include <execution>
+#if defined(__cpp_lib_parallel_algorithm) || defined(_MSC_VER)
+#define HAS_PARALLEL_STL
+#endif
+#endif
+
+using namespace std;
+
+
+//========================================================================================
+//                          Benchmark Infrastructure Code
+//========================================================================================
+
+class Stopwatch
+{
+public:
+    Stopwatch() = default;
+
+    void Start()
+    {
+        m_start = std::chrono::high_resolution_clock::now();
+    }
+
+    void Stop()
+    {
+        TimePoint finish = std::chrono::high_resolution_clock::now();
+        m_elapsed = finish - m_start;
+    }
+
+    double ElapsedMilliseconds() const
+    {
+        return m_elapsed.count() * 1000.0;
+    }
+
+    void PrintTime(const char* s)
+    {
+        std::cout << s << ": " << (m_elapsed.count() * 1000.0) << " ms\n";
+    }
+
+private:
+    typedef std::chrono::time_point<std::chrono::high_resolution_clock> TimePoint;
+
+    TimePoint m_start{};
+    std::chrono::duration<double> m_elapsed{};
+};
+
+
+inline void PrintTestConditions() 
+{
+    cout << "(";
+#if defined(_M_X64)
+    cout << "64-bit";
+#elif defined(_M_IX86)
+    cout << "32-bit";
+#endif
+
+#ifdef TEST_SSO
+    cout << "; testing with small strings)";
+#else
+    cout << ")";
+#endif
+
+    cout << "\n\n";
+}
+
+
+//========================================================================================
+//                              Main Benchmark Code
+//========================================================================================
+
+// Build the shuffled test strings.
+vector<wstring> BuildShuffledStrings()
+{
+    const wstring lorem[] = {
+        L"Lorem ipsum dolor sit amet, consectetuer adipiscing elit.",
+        L"Maecenas porttitor congue massa. Fusce posuere, magna sed",
+        L"pulvinar ultricies, purus lectus malesuada libero,",
+        L"sit amet commodo magna eros quis urna.",
+        L"Nunc viverra imperdiet enim. Fusce est. Vivamus a tellus.",
+        L"Pellentesque habitant morbi tristique senectus et netus et",
+        L"malesuada fames ac turpis egestas. Proin pharetra nonummy pede.",
+        L"Mauris et orci. [*** add more chars to prevent SSO ***]"
+    };
+
+    vector<wstring> v;
+
+#ifdef _DEBUG
+    const int kCount = 2;
+#else
+    const int kCount = 200 * 1000;
+#endif
+    for (int i = 0; i < kCount; ++i)
+    {
+        for (auto& s : lorem)
+        {
+
+// 
+// Define TEST_SSO to test with the Small String Optimization
+// 
+
+//#define TEST_SSO
+#ifdef TEST_SSO
+            UNREFERENCED_PARAMETER(s);
+            v.push_back(L"#" + to_wstring(i));
+#else
+            v.push_back(s + L" (#" + to_wstring(i) + L")");
+#endif
+        }
+    }
+
+    mt19937 prng(1729);
+
+    shuffle(v.begin(), v.end(), prng);
+
+    return v;
+}
+
+void Benchmark()
+{
+    //------------------------------------------------------------------------------------
+    // Build the test strings
+    //------------------------------------------------------------------------------------
+
+    cout << "Building the string vectors for testing...\n\n";
+    const vector<wstring> shuffled = BuildShuffledStrings();
+
+    const auto shuffled_ptrs = [&]() -> vector<const wchar_t *> {
+        vector<const wchar_t *> v;
+
+        for (auto& s : shuffled) {
+            v.push_back(s.c_str());
+        }
+
+        return v;
+    }();
+
+
+    //------------------------------------------------------------------------------------
+    // Benchmark Building the String Vectors 
+    //------------------------------------------------------------------------------------
+
+    Stopwatch sw;
+
+    sw.Start();
+    vector<wstring> stl1 = shuffled;
+    sw.Stop();
+    sw.PrintTime("Alloc STL1 ");
+
+    sw.Start();
+    StringPool::Allocator poolAlloc1;
+    vector<StringPool::String> pool1;
+    pool1.reserve(shuffled_ptrs.size());
+    for (const auto& s : shuffled_ptrs)
+    {
+        pool1.push_back(poolAlloc1.AllocString(s));
+    }
+    sw.Stop();
+    sw.PrintTime("Alloc Pool1");
+
+
+#define SANITY_CHECK_ON_STRING_VECTOR_CONTENT
+#ifdef SANITY_CHECK_ON_STRING_VECTOR_CONTENT
+    if (pool1.size() != stl1.size())
+    {
+        throw runtime_error("String vectors have different sizes.");
+    }
+
+    const size_t stringCount = stl1.size();
+    for (size_t i = 0; i < stringCount; i++)
+    {
+        if (wstring(pool1[i].Str(), pool1[i].Length()) != stl1[i])
+        {
+            throw runtime_error("Mismatch between STL string and pool-allocated string.");
+        }
+    }
+#endif
+
+    sw.Start();
+    vector<wstring> stl2 = shuffled;
+    sw.Stop();
+    sw.PrintTime("Alloc STL2 ");
+
+    sw.Start();
+    StringPool::Allocator poolAlloc2;
+    vector<StringPool::String> pool2;
+    pool2.reserve(shuffled_ptrs.size());
+    for (const auto& s : shuffled_ptrs)
+    {
+        pool2.push_back(poolAlloc2.AllocString(s));
+    }
+    sw.Stop();
+    sw.PrintTime("Alloc Pool2");
+
+
+    sw.Start();
+    vector<wstring> stl3 = shuffled;
+    sw.Stop();
+    sw.PrintTime("Alloc STL3 ");
+
+    sw.Start();
+    StringPool::Allocator poolAlloc3;
+    vector<StringPool::String> pool3;
+    pool3.reserve(shuffled_ptrs.size());
+    for (const auto& s : shuffled_ptrs)
+    {
+        pool3.push_back(poolAlloc3.AllocString(s));
+    }
+    sw.Stop();
+    sw.PrintTime("Alloc Pool3");
+
+
+    //------------------------------------------------------------------------------------
+    // Benchmark the batch allocation API vs. the AllocString loops above
+    //------------------------------------------------------------------------------------
+
+    cout << "\n";
+
+    sw.Start();
+    StringPool::Allocator poolAllocBatch;
+    vector<StringPool::String> poolBatch;
+    poolAllocBatch.AllocStrings(shuffled_ptrs.data(), shuffled_ptrs.size(), poolBatch);
+    sw.Stop();
+    sw.PrintTime("Alloc Batch");
+
+#ifdef SANITY_CHECK_ON_STRING_VECTOR_CONTENT
+    if (poolBatch.size() != shuffled.size())
+    {
+        throw runtime_error("Batch-allocated string vector has a different size.");
+    }
+
+    for (size_t i = 0; i < stringCount; i++)
+    {
+        if (wstring(poolBatch[i].Str(), poolBatch[i].Length()) != shuffled[i])
+        {
+            throw runtime_error("Mismatch between STL string and batch-allocated string.");
+        }
+    }
+#endif
+
+#ifdef STRINGPOOL_HAS_STRING_VIEW
+    // Batch allocation from string views into a single text buffer, 
+    // e.g. the fields of a parsed file (not NUL-terminated)
+    wstring text;
+    for (const auto& s : shuffled)
+    {
+        text += s;
+    }
+
+    vector<wstring_view> views;
+    views.reserve(shuffled.size());
+    size_t offset = 0;
+    for (const auto& s : shuffled)
+    {
+        views.push_back(wstring_view{ text.data() + offset, s.size() });
+        offset += s.size();
+    }
+
+    sw.Start();
+    StringPool::Allocator poolAllocViews;
+    vector<StringPool::String> poolViews;
+    poolAllocViews.AllocStrings(views.data(), views.size(), poolViews);
+    sw.Stop();
+    sw.PrintTime("Alloc Views");
+
+#ifdef SANITY_CHECK_ON_STRING_VECTOR_CONTENT
+    if (poolViews.size() != shuffled.size())
+    {
+        throw runtime_error("View-allocated string vector has a different size.");
+    }
+
+    for (size_t i = 0; i < stringCount; i++)
+    {
+        if (poolViews[i].Str() != shuffled[i] || poolViews[i].Length() != shuffled[i].size())
+        {
+            throw runtime_error("Mismatch between STL string and view-allocated string.");
+        }
+    }
+#endif
+#endif // STRINGPOOL_HAS_STRING_VIEW
+
+
+    //------------------------------------------------------------------------------------
+    // Benchmark String Vector Sorting
+    //------------------------------------------------------------------------------------
+
+    cout << "\nSorting...\n\n";
+
+    sw.Start();
+    sort(stl1.begin(), stl1.end());
+    sw.Stop();
+    sw.PrintTime("STL1 ");
+
+    sw.Start();
+    sort(pool1.begin(), pool1.end());
+    sw.Stop();
+    sw.PrintTime("Pool1");
+
+    cout << "\n";
+
+    sw.Start();
+    sort(stl2.begin(), stl2.end());
+    sw.Stop();
+    sw.PrintTime("STL2 ");
+
+    sw.Start();
+    sort(pool2.begin(), pool2.end());
+    sw.Stop();
+    sw.PrintTime("Pool2");
+
+    cout << "\n";
+
+    sw.Start();
+    sort(stl3.begin(), stl3.end());
+    sw.Stop();
+    sw.PrintTime("STL3 ");
+
+    sw.Start();
+    sort(pool3.begin(), pool3.end());
+    sw.Stop();
+    sw.PrintTime("Pool3");
+
+    cout << "\n";
+
+    // The batch-allocated vector is still in shuffled order
+    vector<StringPool::String> poolLcp = poolBatch;
+
+    sw.Start();
+    StringPool::Sort(poolBatch.begin(), poolBatch.end());
+    sw.Stop();
+    sw.PrintTime("Radix");
+
+    if (poolBatch != pool1)
+    {
+        throw runtime_error("StringPool::Sort and std::sort results differ.");
+    }
+
+    vector<size_t> lcps;
+    sw.Start();
+    StringPool::LcpMergeSort(poolLcp, lcps);
+    sw.Stop();
+    sw.PrintTime("LCP  ");
+
+    if (poolLcp != pool1)
+    {
+        throw runtime_error("StringPool::LcpMergeSort and std::sort results differ.");
+    }
+
+    //
+    // Merge sorted runs, as coming from different shards
+    //
+    const size_t kRunCount = 8;     // Power of 2, for the balanced merges below
+    vector<vector<StringPool::String>> runs(kRunCount);
+    for (size_t i = 0; i < pool1.size(); ++i)
+    {
+        runs[i % kRunCount].push_back(pool1[i]);
+    }
+
+    // The shards provide their LCP arrays, e.g. from LcpMergeSort
+    vector<vector<size_t>> runLcps(kRunCount);
+    for (size_t i = 0; i < kRunCount; ++i)
+    {
+        StringPool::ComputeLcpArray(runs[i].begin(), runs[i].end(), runLcps[i]);
+    }
+
+    // Same balanced tree of pairwise merges as MergeSortedRuns
+    sw.Start();
+    vector<vector<StringPool::String>> current = runs;
+    while (current.size() > 1)
+    {
+        vector<vector<StringPool::String>> next(current.size() / 2);
+        for (size_t i = 0; i < next.size(); ++i)
+        {
+            const auto& a = current[2 * i];
+            const auto& b = current[2 * i + 1];
+            next[i].reserve(a.size() + b.size());
+            merge(a.begin(), a.end(), b.begin(), b.end(), back_inserter(next[i]));
+        }
+        current.swap(next);
+    }
+    const vector<StringPool::String>& merged = current[0];
+    sw.Stop();
+    sw.PrintTime("Merge runs (std::merge)");
+
+    vector<StringPool::String> lcpMerged;
+    vector<size_t> mergedLcps;
+    sw.Start();
+    StringPool::MergeSortedRuns(runs, runLcps, lcpMerged, mergedLcps);
+    sw.Stop();
+    sw.PrintTime("Merge runs (LCP merge) ");
+
+    if (merged != pool1 || lcpMerged != pool1)
+    {
+        throw runtime_error("Merged runs differ from std::sort results.");
+    }
+}
+
+
+//========================================================================================
+//                      Sorting Benchmark on Random Keys
+//========================================================================================
+
+// Build a vector of random lowercase keys, with random lengths.
+vector<wstring> BuildRandomKeys()
+{
+#ifdef _DEBUG
+    const int kCount = 1000;
+#else
+    const int kCount = 1600 * 1000;
+#endif
+
+    mt19937 prng(1729);
+    uniform_int_distribution<int> randomLength(1, 24);
+    uniform_int_distribution<int> randomChar(L'a', L'z');
+
+    vector<wstring> keys;
+    keys.reserve(kCount);
+    for (int i = 0; i < kCount; ++i)
+    {
+        wstring key(randomLength(prng), L' ');
+        for (auto& ch : key)
+        {
+            ch = static_cast<wchar_t>(randomChar(prng));
+        }
+        keys.push_back(key);
+    }
+
+    return keys;
+}
+
+void BenchmarkRandomKeySort()
+{
+    cout << "\nSorting random keys...\n\n";
+
+    const vector<wstring> keys = BuildRandomKeys();
+
+    StringPool::Allocator poolAlloc;
+    vector<StringPool::String> pool1;
+    poolAlloc.AllocStrings(keys.data(), keys.size(), pool1);
+    vector<StringPool::String> pool2 = pool1;
+
+    Stopwatch sw;
+
+    sw.Start();
+    sort(pool1.begin(), pool1.end());
+    sw.Stop();
+    sw.PrintTime("Pool ");
+
+    sw.Start();
+    StringPool::Sort(pool2.begin(), pool2.end());
+    sw.Stop();
+    sw.PrintTime("Radix");
+
+    if (pool1 != pool2)
+    {
+        throw runtime_error("StringPool::Sort and std::sort results differ.");
+    }
+}
+
+
+//========================================================================================
+//                      Parallel Sorting Benchmark
+//========================================================================================
+
+void BenchmarkParallelSort()
+{
+    cout << "\nParallel sorting of random keys...\n\n";
+
+    const vector<wstring> keys = BuildRandomKeys();
+
+    StringPool::Allocator poolAlloc;
+    vector<StringPool::String> shuffled;
+    poolAlloc.AllocStrings(keys.data(), keys.size(), shuffled);
+
+    Stopwatch sw;
+
+    vector<StringPool::String> expected = shuffled;
+    sw.Start();
+    sort(expected.begin(), expected.end());
+    sw.Stop();
+    sw.PrintTime("std::sort           ");
+
+#ifdef HAS_PARALLEL_STL
+    vector<StringPool::String> pool = shuffled;
+    sw.Start();
+    sort(execution::par, pool.begin(), pool.end());
+    sw.Stop();
+    sw.PrintTime("std::sort(par)      ");
+#endif
+
+    // Scale from 1 to N threads
+    unsigned int maxThreads = thread::hardware_concurrency();
+    if (maxThreads == 0)
+    {
+        maxThreads = 1;
+    }
+
+    for (unsigned int threadCount = 1; ; threadCount *= 2)
+    {
+        if (threadCount > maxThreads)
+        {
+            threadCount = maxThreads;
+        }
+
+        vector<StringPool::String> parallel = shuffled;
+        sw.Start();
+        StringPool::ParallelSort(parallel.begin(), parallel.end(), threadCount);
+        sw.Stop();
+
+        const string label = "ParallelSort (" + to_string(threadCount) + " thr)";
+        sw.PrintTime(label.c_str());
+
+        if (parallel != expected)
+        {
+            throw runtime_error("StringPool::ParallelSort and std::sort results differ.");
+        }
+
+        if (threadCount == maxThreads)
+        {
+            break;
+        }
+    }
+}
+
+
+//========================================================================================
+//                      String Comparison Microbenchmark
+//========================================================================================
+
+// The original String::Compare implementation, based on wmemcmp.
+int CompareWithWmemcmp(const StringPool::String& a, const StringPool::String& b)
+{
+    const size_t minLength = a.Length() < b.Length() ? a.Length() : b.Length();
+
+    const int result = wmemcmp(a.Str(), b.Str(), minLength);
+    if (result != 0)
+        return result;
+
+    if (a.Length() < b.Length())
+        return -1;
+
+    if (a.Length() > b.Length())
+        return 1;
+
+    return 0;
+}
+
+void BenchmarkCompare()
+{
+    cout << "\nComparing strings with different common prefix lengths...\n\n";
+
+#ifdef _DEBUG
+    const int kIterations = 1000;
+#else
+    const int kIterations = 10 * 1000 * 1000;
+#endif
+
+    StringPool::Allocator poolAlloc;
+    Stopwatch sw;
+
+    for (size_t prefixLength : { 0, 8, 32, 128, 512 })
+    {
+        // Two strings that differ right after the common prefix
+        wstring s1(prefixLength + 8, L'a');
+        wstring s2 = s1;
+        s2[prefixLength] = L'b';
+
+        const StringPool::String a = poolAlloc.AllocString(s1.c_str());
+        const StringPool::String b = poolAlloc.AllocString(s2.c_str());
+
+        // Prevent the compiler from optimizing the loops away
+        volatile int sink = 0;
+
+        cout << "Common prefix: " << prefixLength << "\n";
+
+        sw.Start();
+        for (int i = 0; i < kIterations; ++i)
+        {
+            sink = sink + CompareWithWmemcmp(a, b);
+        }
+        sw.Stop();
+        sw.PrintTime("  wmemcmp        ");
+
+        sw.Start();
+        for (int i = 0; i < kIterations; ++i)
+        {
+            sink = sink + a.Compare(b);
+        }
+        sw.Stop();
+        sw.PrintTime("  String::Compare");
+
+        if ((CompareWithWmemcmp(a, b) < 0) != (a.Compare(b) < 0))
+        {
+            throw runtime_error("String::Compare and wmemcmp results differ.");
+        }
+    }
+
+    // Equality of strings with different lengths: no need to scan the characters
+    wstring longString(512, L'a');
+    const StringPool::String a = poolAlloc.AllocString(longString.c_str());
+    longString.push_back(L'a');
+    const StringPool::String b = poolAlloc.AllocString(longString.c_str());
+
+    volatile bool sink = false;
+
+    cout << "Equality, different lengths:\n";
+
+    sw.Start();
+    for (int i = 0; i < kIterations; ++i)
+    {
+        sink = sink || (CompareWithWmemcmp(a, b) == 0);
+    }
+    sw.Stop();
+    sw.PrintTime("  wmemcmp        ");
+
+    sw.Start();
+    for (int i = 0; i < kIterations; ++i)
+    {
+        sink = sink || (a == b);
+    }
+    sw.Stop();
+    sw.PrintTime("  operator==     ");
+}
+
+
+//========================================================================================
+//                      Character Type Benchmark
+//========================================================================================
+
+// Allocate and sort the benchmark strings in a pool of the given character type,
+// printing the pool memory and the timings.
+// 'sorted' are the same strings, already sorted, to check the results.
+template <typename CharT>
+void BenchmarkCharType(const char* name, const vector<wstring>& shuffled, 
+                       const vector<wstring>& sorted)
+{
+    // The test strings are ASCII, so they can be converted with a simple cast
+    const auto convert = [](const wstring& s)
+    {
+        basic_string<CharT> result(s.size(), CharT());
+        transform(s.begin(), s.end(), result.begin(), 
+                  [](wchar_t ch) { return static_cast<CharT>(ch); });
+        return result;
+    };
+
+    vector<basic_string<CharT>> source;
+    source.reserve(shuffled.size());
+    for (const auto& s : shuffled)
+    {
+        source.push_back(convert(s));
+    }
+
+    cout << name << " (" << sizeof(CharT) << " byte" << (sizeof(CharT) > 1 ? "s" : "") 
+         << " per char)\n";
+
+    Stopwatch sw;
+
+    StringPool::BasicAllocator<CharT> poolAlloc;
+    vector<StringPool::BasicString<CharT>> pool1;
+    sw.Start();
+    poolAlloc.AllocStrings(source.data(), source.size(), pool1);
+    sw.Stop();
+    sw.PrintTime("  Alloc    ");
+
+    cout << "  Pool memory: " << (poolAlloc.AllocatedBytes() / 1024) << " KB\n";
+
+    vector<StringPool::BasicString<CharT>> pool2 = pool1;
+
+    sw.Start();
+    sort(pool1.begin(), pool1.end());
+    sw.Stop();
+    sw.PrintTime("  std::sort");
+
+    sw.Start();
+    StringPool::Sort(pool2.begin(), pool2.end());
+    sw.Stop();
+    sw.PrintTime("  Radix    ");
+
+    // Sanity check: ASCII strings sort in the same order with any character type
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        if (pool1[i].ToStdString() != convert(sorted[i]) || !(pool1[i] == pool2[i]))
+        {
+            throw runtime_error(string("Wrong sort results with ") + name + " pool.");
+        }
+    }
+}
+
+void BenchmarkCharTypes()
+{
+    cout << "\nComparing pools of different character types...\n\n";
+
+    const vector<wstring> shuffled = BuildShuffledStrings();
+    vector<wstring> sorted = shuffled;
+    sort(sorted.begin(), sorted.end());
+
+    BenchmarkCharType<char>("char", shuffled, sorted);
+#if defined(__cpp_char8_t)
+    BenchmarkCharType<char8_t>("char8_t", shuffled, sorted);
+#endif
+    BenchmarkCharType<char16_t>("char16_t", shuffled, sorted);
+    BenchmarkCharType<char32_t>("char32_t", shuffled, sorted);
+    BenchmarkCharType<wchar_t>("wchar_t", shuffled, sorted);
+}
+
+
+//========================================================================================
+//                      UTF-8 Transcoding Benchmark
+//========================================================================================
+
+// Simple code-point-at-a-time UTF-8 to std::wstring conversion, used as a baseline.
+// Assumes valid UTF-8.
+wstring Utf8ToWstring(const string& utf8)
+{
+    wstring result;
+    result.reserve(utf8.size());
+
+    for (size_t i = 0; i < utf8.size(); )
+    {
+        const unsigned char lead = static_cast<unsigned char>(utf8[i]);
+        const size_t size = lead < 0x80 ? 1 : (lead < 0xE0 ? 2 : (lead < 0xF0 ? 3 : 4));
+
+        char32_t cp = size == 1 ? lead : (lead & (0x7F >> size));
+        for (size_t j = 1; j < size; ++j)
+        {
+            cp = (cp << 6) | (static_cast<unsigned char>(utf8[i + j]) & 0x3F);
+        }
+        i += size;
+
+        if (sizeof(wchar_t) == 2 && cp >= 0x10000)
+        {
+            cp -= 0x10000;
+            result.push_back(static_cast<wchar_t>(0xD800 + (cp >> 10)));
+            result.push_back(static_cast<wchar_t>(0xDC00 + (cp & 0x3FF)));
+        }
+        else
+        {
+            result.push_back(static_cast<wchar_t>(cp));
+        }
+    }
+
+    return result;
+}
+
+void BenchmarkUtf8()
+{
+    cout << "\nTranscoding UTF-8 strings into the pool...\n\n";
+
+    // Mostly-ASCII UTF-8 strings, with some non-ASCII ones
+    vector<string> utf8;
+    {
+        const vector<wstring> shuffled = BuildShuffledStrings();
+        StringPool::Allocator poolAlloc;
+
+        utf8.reserve(shuffled.size());
+        for (size_t i = 0; i < shuffled.size(); ++i)
+        {
+            const wstring s = (i % 4 == 0) ? 
+                shuffled[i] + L" \u00E0 la caf\u00E9 \u4E2D\u6587" : shuffled[i];
+            utf8.push_back(StringPool::ToUtf8(poolAlloc.AllocString(s.c_str())));
+        }
+    }
+
+    Stopwatch sw;
+
+    StringPool::Allocator poolAlloc1;
+    vector<StringPool::String> pool1;
+    pool1.reserve(utf8.size());
+    sw.Start();
+    for (const auto& s : utf8)
+    {
+        const wstring wide = Utf8ToWstring(s);
+        pool1.push_back(poolAlloc1.AllocString(wide.c_str(), wide.c_str() + wide.size()));
+    }
+    sw.Stop();
+    sw.PrintTime("wstring + AllocString");
+
+    StringPool::Allocator poolAlloc2;
+    vector<StringPool::String> pool2;
+    pool2.reserve(utf8.size());
+    sw.Start();
+    for (const auto& s : utf8)
+    {
+        pool2.push_back(poolAlloc2.AllocStringFromUtf8(s));
+    }
+    sw.Stop();
+    sw.PrintTime("AllocStringFromUtf8  ");
+
+    if (pool1 != pool2)
+    {
+        throw runtime_error("AllocStringFromUtf8 results differ from the baseline.");
+    }
+
+    string exported;
+    sw.Start();
+    for (const auto& s : pool2)
+    {
+        exported.clear();
+        StringPool::AppendUtf8(s, exported);
+    }
+    sw.Stop();
+    sw.PrintTime("AppendUtf8           ");
+
+    // Sanity check: round trip
+    for (size_t i = 0; i < utf8.size(); ++i)
+    {
+        if (StringPool::ToUtf8(pool2[i]) != utf8[i])
+        {
+            throw runtime_error("UTF-8 round trip failed.");
+        }
+    }
+}
+
+
+//========================================================================================
+//                      Case-Folded Allocation Benchmark
+//========================================================================================
+
+void BenchmarkCaseFolding()
+{
+    cout << "\nAllocating case-folded strings...\n\n";
+
+    const vector<wstring> shuffled = BuildShuffledStrings();
+
+    Stopwatch sw;
+
+    // Baseline: lowercase a copy of each string, then allocate it
+    StringPool::Allocator poolAlloc1;
+    vector<StringPool::String> pool1;
+    pool1.reserve(shuffled.size());
+    sw.Start();
+    for (const auto& s : shuffled)
+    {
+        wstring lower = s;
+        transform(lower.begin(), lower.end(), lower.begin(), 
+                  [](wchar_t ch) { return static_cast<wchar_t>(towlower(ch)); });
+        pool1.push_back(poolAlloc1.AllocString(lower.c_str(), lower.c_str() + lower.size()));
+    }
+    sw.Stop();
+    sw.PrintTime("towlower + AllocString");
+
+    StringPool::Allocator poolAlloc2;
+    vector<StringPool::String> pool2;
+    pool2.reserve(shuffled.size());
+    sw.Start();
+    for (const auto& s : shuffled)
+    {
+        pool2.push_back(poolAlloc2.AllocStringFolded(s.c_str(), s.c_str() + s.size()));
+    }
+    sw.Stop();
+    sw.PrintTime("AllocStringFolded     ");
+
+    // Sanity check: the test strings are ASCII, so folding is just lowercasing
+    if (pool1 != pool2)
+    {
+        throw runtime_error("AllocStringFolded results differ from towlower.");
+    }
+
+    // Case-insensitive sort of the original strings vs. plain sort of the folded ones
+    vector<StringPool::String> pool3;
+    StringPool::Allocator poolAlloc3;
+    poolAlloc3.AllocStrings(shuffled.data(), shuffled.size(), pool3);
+
+    sw.Start();
+    sort(pool3.begin(), pool3.end(), StringPool::CaseInsensitiveLess{});
+    sw.Stop();
+    sw.PrintTime("Sort CaseInsensitive  ");
+
+    sw.Start();
+    sort(pool2.begin(), pool2.end());
+    sw.Stop();
+    sw.PrintTime("Sort folded           ");
+
+    for (size_t i = 0; i < pool2.size(); ++i)
+    {
+        if (StringPool::CompareIgnoreCase(pool2[i], pool3[i]) != 0)
+        {
+            throw runtime_error("Case-insensitive sort results differ.");
+        }
+    }
+}
+
+
+//========================================================================================
+//                      Memory Resource Benchmark
+//========================================================================================
+
+#ifdef STRINGPOOL_HAS_PMR
+
+// Build a std::pmr::vector of std::pmr::wstrings, using the given memory resource.
+void BuildPmrStrings(const vector<wstring>& source, pmr::memory_resource* resource,
+                     Stopwatch& sw, const char* label)
+{
+    sw.Start();
+    pmr::vector<pmr::wstring> strings(resource);
+    strings.reserve(source.size());
+    for (const auto& s : source)
+    {
+        strings.emplace_back(s.c_str(), s.size());
+    }
+    sw.Stop();
+    sw.PrintTime(label);
+
+    // Sanity check
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        if (strings[i].compare(0, wstring::npos, source[i].c_str(), source[i].size()) != 0)
+        {
+            throw runtime_error(string("Wrong strings with ") + label);
+        }
+    }
+}
+
+void BenchmarkMemoryResource()
+{
+    cout << "\nBuilding string vectors with memory resources...\n\n";
+
+    const vector<wstring> shuffled = BuildShuffledStrings();
+
+    Stopwatch sw;
+
+    {
+        pmr::monotonic_buffer_resource monotonic;
+        BuildPmrStrings(shuffled, &monotonic, sw, "pmr::wstring, monotonic_buffer_resource");
+    }
+
+    {
+        StringPool::Allocator poolAlloc;
+        StringPool::MemoryResource poolResource(poolAlloc);
+        BuildPmrStrings(shuffled, &poolResource, sw, "pmr::wstring, StringPool::MemoryResource");
+    }
+
+    {
+        // Both the strings and the vector in the same pool
+        StringPool::Allocator poolAlloc;
+        StringPool::MemoryResource poolResource(poolAlloc);
+
+        sw.Start();
+        pmr::vector<StringPool::String> pool(&poolResource);
+        pool.reserve(shuffled.size());
+        for (const auto& s : shuffled)
+        {
+            pool.push_back(poolAlloc.AllocString(s.c_str(), s.c_str() + s.size()));
+        }
+        sw.Stop();
+        sw.PrintTime("String, pmr::vector on MemoryResource   ");
+
+        for (size_t i = 0; i < shuffled.size(); ++i)
+        {
+            if (pool[i].ToStdString() != shuffled[i])
+            {
+                throw runtime_error("Wrong strings in the pool memory resource.");
+            }
+        }
+    }
+}
+
+#endif // STRINGPOOL_HAS_PMR
+
+
+//========================================================================================
+//                      STL Allocator Benchmark
+//========================================================================================
+
+// Build a map from the pooled strings to their indexes, then destroy it.
+template <typename Map>
+void BuildStringIndex(const vector<StringPool::String>& strings, Map& index)
+{
+    for (size_t i = 0; i < strings.size(); ++i)
+    {
+        index.emplace(strings[i], i);
+    }
+
+    // Sanity check
+    if (index.size() != strings.size() || index.find(strings[0])->second != 0)
+    {
+        throw runtime_error("Wrong string index.");
+    }
+}
+
+void BenchmarkStlAllocator()
+{
+    cout << "\nBuilding and tearing down a std::map index of pooled strings...\n\n";
+
+    const vector<wstring> shuffled = BuildShuffledStrings();
+
+    Stopwatch sw;
+
+    {
+        StringPool::Allocator poolAlloc;
+        vector<StringPool::String> strings;
+        poolAlloc.AllocStrings(shuffled.data(), shuffled.size(), strings);
+
+        sw.Start();
+        {
+            map<StringPool::String, size_t> index;
+            BuildStringIndex(strings, index);
+        }
+        poolAlloc.Clear();
+        sw.Stop();
+        sw.PrintTime("std::allocator nodes");
+    }
+
+    {
+        // The strings and the map nodes in the same pool
+        typedef StringPool::StlAllocator<pair<const StringPool::String, size_t>> NodeAllocator;
+
+        StringPool::Allocator poolAlloc;
+        vector<StringPool::String> strings;
+        poolAlloc.AllocStrings(shuffled.data(), shuffled.size(), strings);
+
+        sw.Start();
+        {
+            map<StringPool::String, size_t, less<StringPool::String>, NodeAllocator> index{
+                NodeAllocator{ poolAlloc } };
+            BuildStringIndex(strings, index);
+        }
+        poolAlloc.Clear();
+        sw.Stop();
+        sw.PrintTime("StlAllocator nodes  ");
+    }
+}
+
+
+//========================================================================================
+//                      String View Lookup Benchmark
+//========================================================================================
+
+#ifdef STRINGPOOL_HAS_STRING_VIEW
+
+// Look up the pooled strings in a std::wstring-keyed map, 
+// returning the sum of the found values.
+template <typename Map, typename KeyFunc>
+size_t LookUpStrings(const Map& index, const vector<StringPool::String>& strings, 
+                     KeyFunc key)
+{
+    size_t sum = 0;
+    for (const auto& s : strings)
+    {
+        sum += index.find(key(s))->second;
+    }
+    return sum;
+}
+
+void BenchmarkStringViewLookup()
+{
+    cout << "\nLooking up pooled strings in a std::wstring map...\n\n";
+
+    const vector<wstring> shuffled = BuildShuffledStrings();
+
+    StringPool::Allocator poolAlloc;
+    vector<StringPool::String> strings;
+    poolAlloc.AllocStrings(shuffled.data(), shuffled.size(), strings);
+
+    // Transparent comparator, to look up by views too
+    map<wstring, size_t, less<>> index;
+    for (size_t i = 0; i < shuffled.size(); ++i)
+    {
+        index.emplace(shuffled[i], i);
+    }
+
+    Stopwatch sw;
+
+    sw.Start();
+    const size_t sum1 = LookUpStrings(index, strings, 
+        [](const StringPool::String& s) { return s.ToStdString(); });
+    sw.Stop();
+    sw.PrintTime("ToStdString keys");
+
+    sw.Start();
+    const size_t sum2 = LookUpStrings(index, strings, 
+        [](const StringPool::String& s) { return s.View(); });
+    sw.Stop();
+    sw.PrintTime("View keys       ");
+
+    // Sanity check, also for the heterogeneous operators
+    if (sum1 != sum2 
+        || strings[0] != wstring_view{ shuffled[0] } || shuffled[0] != strings[0])
+    {
+        throw runtime_error("String view lookups differ.");
+    }
+}
+
+#endif // STRINGPOOL_HAS_STRING_VIEW
+
+
+//========================================================================================
+//                      Front-Coded Dictionary Benchmark
+//========================================================================================
+
+void BenchmarkDictionary()
+{
+    cout << "\nFront-coded dictionary vs. sorted pooled strings...\n\n";
+
+    const vector<wstring> shuffled = BuildShuffledStrings();
+
+    StringPool::Allocator poolAlloc;
+    vector<StringPool::String> sorted;
+    poolAlloc.AllocStrings(shuffled.data(), shuffled.size(), sorted);
+    StringPool::Sort(sorted.begin(), sorted.end());
+
+    Stopwatch sw;
+
+    sw.Start();
+    const StringPool::FrontCodedDictionary dictionary{ sorted };
+    sw.Stop();
+    sw.PrintTime("Build dictionary ");
+
+    const size_t poolBytes = poolAlloc.AllocatedBytes() 
+        + (sorted.size() * sizeof(StringPool::String));
+    cout << "Pool memory      : " << (poolBytes / 1024) << " KB\n";
+    cout << "Dictionary memory: " << (dictionary.MemoryBytes() / 1024) << " KB\n";
+
+    // Look up all the strings, in shuffled order
+    StringPool::Allocator keyAlloc;
+    vector<StringPool::String> keys;
+    keyAlloc.AllocStrings(shuffled.data(), shuffled.size(), keys);
+
+    size_t poolFound = 0;
+    sw.Start();
+    for (const auto& key : keys)
+    {
+        poolFound += binary_search(sorted.begin(), sorted.end(), key) ? 1 : 0;
+    }
+    sw.Stop();
+    sw.PrintTime("Pool lookups     ");
+
+    size_t dictionaryFound = 0;
+    sw.Start();
+    for (const auto& key : keys)
+    {
+        dictionaryFound += (dictionary.Find(key) != dictionary.kNotFound) ? 1 : 0;
+    }
+    sw.Stop();
+    sw.PrintTime("Dictionary Find  ");
+
+    // Sanity check, also for Select and prefix iteration
+    size_t prefixCount = 0;
+    dictionary.ForEachWithPrefix(sorted[0], [&](size_t id, const wstring& s) 
+    {
+        if (s != dictionary.Select(id))
+        {
+            throw runtime_error("Dictionary prefix iteration and Select differ.");
+        }
+        ++prefixCount;
+    });
+
+    if (poolFound != keys.size() || dictionaryFound != keys.size() || prefixCount == 0
+        || dictionary.Select(dictionary.Size() - 1) != sorted.back().ToStdString())
+    {
+        throw runtime_error("Dictionary and pool lookups differ.");
+    }
+}
+
+
+//========================================================================================
+//                      Compressed Pool Benchmark
+//========================================================================================
+
+void BenchmarkCompression()
+{
+    cout << "\nCompressed pool vs. plain pool...\n\n";
+
+    const vector<wstring> shuffled = BuildShuffledStrings();
+
+    StringPool::Allocator poolAlloc;
+    vector<StringPool::String> strings;
+    poolAlloc.AllocStrings(shuffled.data(), shuffled.size(), strings);
+
+    Stopwatch sw;
+
+    StringPool::CompressedPool compressedPool;
+    sw.Start();
+    compressedPool.Train(strings);
+    sw.Stop();
+    sw.PrintTime("Train symbol table ");
+
+    vector<StringPool::CompressedString> compressed;
+    compressed.reserve(strings.size());
+    sw.Start();
+    for (const auto& s : strings)
+    {
+        compressed.push_back(compressedPool.AllocString(s));
+    }
+    sw.Stop();
+    sw.PrintTime("Compress strings   ");
+
+    const size_t poolBytes = poolAlloc.AllocatedBytes() 
+        + (strings.size() * sizeof(StringPool::String));
+    const size_t compressedBytes = compressedPool.AllocatedBytes() 
+        + (compressed.size() * sizeof(StringPool::CompressedString));
+    cout << "Pool memory        : " << (poolBytes / 1024) << " KB\n";
+    cout << "Compressed memory  : " << (compressedBytes / 1024) << " KB ("
+        << compressedPool.SymbolCount() << " symbols)\n";
+
+    // Random-access decompression, reusing the output string
+    wstring buffer;
+    size_t totalLength = 0;
+    sw.Start();
+    for (const auto& s : compressed)
+    {
+        compressedPool.Decompress(s, buffer);
+        totalLength += buffer.size();
+    }
+    sw.Stop();
+    sw.PrintTime("Decompress strings ");
+
+    // Compare adjacent strings, decompressing vs. in the compressed domain
+    size_t decompressedEqual = 0;
+    wstring other;
+    sw.Start();
+    for (size_t i = 1; i < compressed.size(); ++i)
+    {
+        compressedPool.Decompress(compressed[i - 1], buffer);
+        compressedPool.Decompress(compressed[i], other);
+        decompressedEqual += (buffer == other) ? 1 : 0;
+    }
+    sw.Stop();
+    sw.PrintTime("Decompress+compare ");
+
+    size_t compressedEqual = 0;
+    sw.Start();
+    for (size_t i = 1; i < compressed.size(); ++i)
+    {
+        compressedEqual += (compressed[i - 1] == compressed[i]) ? 1 : 0;
+    }
+    sw.Stop();
+    sw.PrintTime("Compressed compare ");
+
+    // Sanity check
+    for (size_t i = 0; i < strings.size(); i += 97)
+    {
+        if (compressedPool.Decompress(compressed[i]) != shuffled[i]
+            || !(compressed[i] == compressedPool.AllocString(shuffled[i].c_str())))
+        {
+            throw runtime_error("Compressed and original strings differ.");
+        }
+    }
+
+    size_t expectedLength = 0;
+    for (const auto& s : shuffled)
+    {
+        expectedLength += s.size();
+    }
+
+    if (totalLength != expectedLength || decompressedEqual != compressedEqual)
+    {
+        throw runtime_error("Compressed pool results differ.");
+    }
+}
+
+
+//========================================================================================
+//                      ART Index Benchmark
+//========================================================================================
+
+void BenchmarkArtIndex()
+{
+    cout << "\nART index vs. std::map vs. sorted vector...\n\n";
+
+    const vector<wstring> shuffled = BuildShuffledStrings();
+
+    StringPool::Allocator poolAlloc;
+    vector<StringPool::String> strings;
+    poolAlloc.AllocStrings(shuffled.data(), shuffled.size(), strings);
+
+    Stopwatch sw;
+
+    // Map each string to its position in the shuffled vector
+    sw.Start();
+    StringPool::ArtIndex<size_t> art{ poolAlloc };
+    for (size_t i = 0; i < strings.size(); ++i)
+    {
+        art.Insert(strings[i], i);
+    }
+    sw.Stop();
+    sw.PrintTime("ART build          ");
+
+    sw.Start();
+    map<StringPool::String, size_t> stlMap;
+    for (size_t i = 0; i < strings.size(); ++i)
+    {
+        stlMap.emplace(strings[i], i);
+    }
+    sw.Stop();
+    sw.PrintTime("std::map build     ");
+
+    // Sorted vector of the unique keys, taken from the map
+    vector<StringPool::String> sorted;
+    sorted.reserve(stlMap.size());
+    for (const auto& entry : stlMap)
+    {
+        sorted.push_back(entry.first);
+    }
+
+    // Point lookups, in shuffled order
+    size_t artFound = 0;
+    sw.Start();
+    for (const auto& key : strings)
+    {
+        artFound += (art.Find(key) != nullptr) ? 1 : 0;
+    }
+    sw.Stop();
+    sw.PrintTime("ART Find           ");
+
+    size_t mapFound = 0;
+    sw.Start();
+    for (const auto& key : strings)
+    {
+        mapFound += (stlMap.find(key) != stlMap.end()) ? 1 : 0;
+    }
+    sw.Stop();
+    sw.PrintTime("std::map find      ");
+
+    size_t sortedFound = 0;
+    sw.Start();
+    for (const auto& key : strings)
+    {
+        sortedFound += binary_search(sorted.begin(), sorted.end(), key) ? 1 : 0;
+    }
+    sw.Stop();
+    sw.PrintTime("Binary search      ");
+
+    // Prefix scans: some keys without their last 3 characters 
+    // (matching about one hundred keys each)
+    StringPool::Allocator prefixAlloc;
+    vector<StringPool::String> prefixes;
+    for (size_t i = 0; i < strings.size(); i += 100)
+    {
+        const size_t length = strings[i].Length() - min<size_t>(3, strings[i].Length());
+        prefixes.push_back(prefixAlloc.AllocString(strings[i].Str(), 
+                                                   strings[i].Str() + length));
+    }
+
+    auto startsWith = [](const StringPool::String& s, const StringPool::String& prefix)
+    {
+        return s.Length() >= prefix.Length()
+            && equal(prefix.Str(), prefix.Str() + prefix.Length(), s.Str());
+    };
+
+    size_t artPrefixCount = 0;
+    sw.Start();
+    for (const auto& prefix : prefixes)
+    {
+        art.ForEachWithPrefix(prefix, [&](const StringPool::String&, size_t&)
+        {
+            ++artPrefixCount;
+        });
+    }
+    sw.Stop();
+    sw.PrintTime("ART prefix scan    ");
+
+    size_t mapPrefixCount = 0;
+    sw.Start();
+    for (const auto& prefix : prefixes)
+    {
+        for (auto it = stlMap.lower_bound(prefix); 
+             it != stlMap.end() && startsWith(it->first, prefix); 
+             ++it)
+        {
+            ++mapPrefixCount;
+        }
+    }
+    sw.Stop();
+    sw.PrintTime("std::map prefix    ");
+
+    size_t sortedPrefixCount = 0;
+    sw.Start();
+    for (const auto& prefix : prefixes)
+    {
+        for (auto it = lower_bound(sorted.begin(), sorted.end(), prefix); 
+             it != sorted.end() && startsWith(*it, prefix); 
+             ++it)
+        {
+            ++sortedPrefixCount;
+        }
+    }
+    sw.Stop();
+    sw.PrintTime("Sorted prefix      ");
+
+    // Sanity check, also for the range scan
+    size_t rangeCount = 0;
+    art.ForEachInRange(sorted[sorted.size() / 4], sorted[sorted.size() / 2], 
+        [&](const StringPool::String&, size_t&)
+    {
+        ++rangeCount;
+    });
+
+    if (artFound != strings.size() || mapFound != strings.size() 
+        || sortedFound != strings.size() || art.Size() != sorted.size()
+        || artPrefixCount != mapPrefixCount || artPrefixCount != sortedPrefixCount
+        || rangeCount != sorted.size() / 2 - sorted.size() / 4)
+    {
+        throw runtime_error("ART index, std::map and sorted vector results differ.");
+    }
+}
+
+
+//========================================================================================
+//                      String Hash Map Benchmark
+//========================================================================================
+
+void BenchmarkHashMap()
+{
+    cout << "\nStringHashMap vs. std::unordered_map<wstring>...\n\n";
+
+    const vector<wstring> shuffled = BuildShuffledStrings();
+
+    StringPool::Allocator poolAlloc;
+    vector<StringPool::String> strings;
+    poolAlloc.AllocStrings(shuffled.data(), shuffled.size(), strings);
+
+    Stopwatch sw;
+
+    // Map each string to its position in the shuffled vector
+    sw.Start();
+    unordered_map<wstring, size_t> stlMap;
+    for (size_t i = 0; i < shuffled.size(); ++i)
+    {
+        stlMap.emplace(shuffled[i], i);
+    }
+    sw.Stop();
+    sw.PrintTime("std::unordered_map build");
+
+    sw.Start();
+    StringPool::StringHashMap<size_t> hashMap;
+    for (size_t i = 0; i < strings.size(); ++i)
+    {
+        hashMap.Insert(strings[i], i);
+    }
+    sw.Stop();
+    sw.PrintTime("StringHashMap build     ");
+
+    // Look up all the keys (from another pool, so that the strings are compared),
+    // and as many missing keys
+    StringPool::Allocator keyAlloc;
+    vector<StringPool::String> keys;
+    keyAlloc.AllocStrings(shuffled.data(), shuffled.size(), keys);
+
+    vector<wstring> missing;
+    missing.reserve(shuffled.size());
+    for (const auto& s : shuffled)
+    {
+        missing.push_back(s + L"!");
+    }
+    vector<StringPool::String> missingKeys;
+    keyAlloc.AllocStrings(missing.data(), missing.size(), missingKeys);
+
+    size_t stlFound = 0;
+    sw.Start();
+    for (const auto& key : shuffled)
+    {
+        stlFound += (stlMap.find(key) != stlMap.end()) ? 1 : 0;
+    }
+    for (const auto& key : missing)
+    {
+        stlFound += (stlMap.find(key) != stlMap.end()) ? 1 : 0;
+    }
+    sw.Stop();
+    sw.PrintTime("std::unordered_map find ");
+
+    size_t hashMapFound = 0;
+    sw.Start();
+    for (const auto& key : keys)
+    {
+        hashMapFound += (hashMap.Find(key) != nullptr) ? 1 : 0;
+    }
+    for (const auto& key : missingKeys)
+    {
+        hashMapFound += (hashMap.Find(key) != nullptr) ? 1 : 0;
+    }
+    sw.Stop();
+    sw.PrintTime("StringHashMap Find      ");
+
+    // Sanity check
+    for (size_t i = 0; i < keys.size(); i += 101)
+    {
+        if (*hashMap.Find(keys[i]) != stlMap[shuffled[i]])
+        {
+            throw runtime_error("StringHashMap and std::unordered_map values differ.");
+        }
+    }
+
+    if (stlFound != hashMapFound || hashMap.Size() != stlMap.size())
+    {
+        throw runtime_error("StringHashMap and std::unordered_map lookups differ.");
+    }
+}
+
+
+//========================================================================================
+//                      Tokenizer Benchmark
+//========================================================================================
+
+void BenchmarkTokenizer()
+{
+    cout << "\nAllocTokens vs. AllocString per field...\n\n";
+
+    const vector<wstring> shuffled = BuildShuffledStrings();
+
+    // Build blocks of tab-separated fields
+    const size_t kFieldsPerBlock = 1000;
+    vector<wstring> blocks;
+    for (size_t i = 0; i < shuffled.size(); i += kFieldsPerBlock)
+    {
+        wstring block;
+        for (size_t j = i; j < min(shuffled.size(), i + kFieldsPerBlock); ++j)
+        {
+            if (j != i)
+            {
+                block += L'\t';
+            }
+            block += shuffled[j];
+        }
+        blocks.push_back(move(block));
+    }
+
+    // Like a streaming parser, process a batch of blocks at a time, recycling the pool
+    // (so that the timings aren't dominated by the page faults of new chunks), 
+    // and check that both ways give the same fields
+    const size_t kBlocksPerBatch = 10;
+
+    Stopwatch swFields;
+    Stopwatch swTokens;
+    double fieldsTime = 0.0;
+    double tokensTime = 0.0;
+    size_t tokenCount = 0;
+
+    StringPool::Allocator fieldAlloc;
+    StringPool::Allocator tokenAlloc;
+    vector<StringPool::String> fields;
+    vector<StringPool::String> tokens;
+
+    for (size_t batch = 0; batch < blocks.size(); batch += kBlocksPerBatch)
+    {
+        const size_t batchEnd = min(blocks.size(), batch + kBlocksPerBatch);
+
+        fieldAlloc.Clear();
+        fields.clear();
+        swFields.Start();
+        for (size_t b = batch; b < batchEnd; ++b)
+        {
+            const wchar_t* start = blocks[b].data();
+            const wchar_t* end = blocks[b].data() + blocks[b].size();
+            for (;;)
+            {
+                const wchar_t* delimiter = find(start, end, L'\t');
+                fields.push_back(fieldAlloc.AllocString(start, delimiter));
+                if (delimiter == end)
+                {
+                    break;
+                }
+                start = delimiter + 1;
+            }
+        }
+        swFields.Stop();
+        fieldsTime += swFields.ElapsedMilliseconds();
+
+        tokenAlloc.Clear();
+        tokens.clear();
+        swTokens.Start();
+        for (size_t b = batch; b < batchEnd; ++b)
+        {
+            tokenAlloc.AllocTokens(blocks[b].data(), blocks[b].data() + blocks[b].size(), 
+                                   L'\t', tokens);
+        }
+        swTokens.Stop();
+        tokensTime += swTokens.ElapsedMilliseconds();
+
+        // Sanity check
+        if (tokens.size() != fields.size())
+        {
+            throw runtime_error("Wrong number of tokens.");
+        }
+
+        for (size_t i = 0; i < tokens.size(); ++i)
+        {
+            if (tokens[i] != fields[i] || tokens[i].Str()[tokens[i].Length()] != L'\0')
+            {
+                throw runtime_error("AllocTokens and AllocString results differ.");
+            }
+        }
+        tokenCount += tokens.size();
+    }
+
+    cout << "AllocString per field: " << fieldsTime << " ms\n";
+    cout << "AllocTokens          : " << tokensTime << " ms\n";
+
+    if (tokenCount != shuffled.size())
+    {
+        throw runtime_error("Wrong number of tokens.");
+    }
+}
+
+
+//========================================================================================
+//                      Line Reader Benchmark
+//========================================================================================
+
+// Print the throughput of reading 'bytes' in the measured time.
+void PrintThroughput(const char* s, const Stopwatch& sw, uint64_t bytes)
+{
+    cout << s << ": " << sw.ElapsedMilliseconds() << " ms ("
+        << (bytes / (sw.ElapsedMilliseconds() / 1000.0) / 1e9) << " GB/s)\n";
+}
+
+void BenchmarkLineReader()
+{
+    cout << "\nLineReader vs. iostream + getline + AllocString...\n\n";
+
+    // Write the test strings (pure ASCII) to a text file, one per line
+    const char* path = "StringPoolLines.txt";
+    const vector<wstring> shuffled = BuildShuffledStrings();
+    uint64_t fileSize = 0;
+    {
+        ofstream file(path, ios::binary);
+        string line;
+        for (const auto& s : shuffled)
+        {
+            line.assign(s.begin(), s.end());
+            line += '\n';
+            file.write(line.data(), line.size());
+            fileSize += line.size();
+        }
+    }
+
+    Stopwatch sw;
+
+    sw.Start();
+    StringPool::Allocator streamAlloc;
+    vector<StringPool::String> streamLines;
+    {
+        wifstream file(path);
+        wstring line;
+        while (getline(file, line))
+        {
+            streamLines.push_back(streamAlloc.AllocString(line.data(), 
+                                                          line.data() + line.size()));
+        }
+    }
+    sw.Stop();
+    PrintThroughput("wifstream + getline   ", sw, fileSize);
+
+    sw.Start();
+    StringPool::Allocator readerAlloc;
+    vector<StringPool::String> readerLines;
+    StringPool::ReadLines(path, readerAlloc, readerLines);
+    sw.Stop();
+    PrintThroughput("LineReader            ", sw, fileSize);
+
+    sw.Start();
+    StringPool::NarrowAllocator narrowStreamAlloc;
+    vector<StringPool::NarrowString> narrowStreamLines;
+    {
+        ifstream file(path, ios::binary);
+        string line;
+        while (getline(file, line))
+        {
+            narrowStreamLines.push_back(narrowStreamAlloc.AllocString(
+                line.data(), line.data() + line.size()));
+        }
+    }
+    sw.Stop();
+    PrintThroughput("ifstream + getline    ", sw, fileSize);
+
+    sw.Start();
+    StringPool::NarrowAllocator narrowReaderAlloc;
+    vector<StringPool::NarrowString> narrowReaderLines;
+    StringPool::ReadLines(path, narrowReaderAlloc, narrowReaderLines);
+    sw.Stop();
+    PrintThroughput("NarrowLineReader      ", sw, fileSize);
+
+    remove(path);
+
+    // Sanity check
+    if (streamLines.size() != shuffled.size() || readerLines.size() != shuffled.size()
+        || narrowStreamLines.size() != shuffled.size() 
+        || narrowReaderLines.size() != shuffled.size())
+    {
+        throw runtime_error("Wrong number of lines.");
+    }
+
+    for (size_t i = 0; i < shuffled.size(); ++i)
+    {
+        if (readerLines[i] != streamLines[i] || readerLines[i].ToStdString() != shuffled[i]
+            || narrowReaderLines[i] != narrowStreamLines[i])
+        {
+            throw runtime_error("LineReader and iostream lines differ.");
+        }
+    }
+}
+
+
+//========================================================================================
+//                      Pool Merging Benchmark
+//========================================================================================
+
+// Allocate the strings in per-thread pools (the pools are moved into the returned 
+// vector), one per thread; 'strings' receives the pooled strings of each thread.
+vector<StringPool::Allocator> BuildThreadPools(const vector<wstring>& source, 
+                                               unsigned int threadCount,
+                                               vector<vector<StringPool::String>>& strings)
+{
+    vector<StringPool::Allocator> pools(threadCount);
+    strings.clear();
+    strings.resize(threadCount);
+
+    const size_t blockSize = (source.size() + threadCount - 1) / threadCount;
+
+    vector<thread> threads;
+    for (unsigned int t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            const size_t first = min(source.size(), t * blockSize);
+            const size_t last = min(source.size(), first + blockSize);
+            pools[t].AllocStrings(source.data() + first, last - first, strings[t]);
+        });
+    }
+
+    for (auto& th : threads)
+    {
+        th.join();
+    }
+
+    return pools;
+}
+
+void BenchmarkMerge()
+{
+    cout << "\nMerging per-thread pools into a global pool...\n\n";
+
+    const vector<wstring> shuffled = BuildShuffledStrings();
+
+    unsigned int threadCount = thread::hardware_concurrency();
+    if (threadCount == 0)
+    {
+        threadCount = 1;
+    }
+
+    Stopwatch sw;
+
+    vector<StringPool::String> copied;
+    {
+        vector<vector<StringPool::String>> strings;
+        vector<StringPool::Allocator> pools = BuildThreadPools(shuffled, threadCount, strings);
+
+        StringPool::Allocator global;
+        sw.Start();
+        for (const auto& threadStrings : strings)
+        {
+            for (const auto& s : threadStrings)
+            {
+                copied.push_back(global.AllocString(s.Str(), s.Str() + s.Length()));
+            }
+        }
+        pools.clear();
+        sw.Stop();
+        sw.PrintTime("Copy strings");
+
+        // Sanity check
+        if (copied.size() != shuffled.size() || copied.back().ToStdString() != shuffled.back())
+        {
+            throw runtime_error("Copied strings differ.");
+        }
+    }
+
+    {
+        vector<vector<StringPool::String>> strings;
+        vector<StringPool::Allocator> pools = BuildThreadPools(shuffled, threadCount, strings);
+
+        StringPool::Allocator global;
+        sw.Start();
+        for (auto& pool : pools)
+        {
+            global.Absorb(std::move(pool));
+        }
+        pools.clear();
+        sw.Stop();
+        sw.PrintTime("Absorb      ");
+
+        // Sanity check: the strings are still valid, now owned by the global pool
+        size_t index = 0;
+        for (const auto& threadStrings : strings)
+        {
+            for (const auto& s : threadStrings)
+            {
+                if (s.ToStdString() != shuffled[index++])
+                {
+                    throw runtime_error("Absorbed strings differ.");
+                }
+            }
+        }
+    }
+}
+
+
+//========================================================================================
+//                      Snapshot Reload Benchmark
+//========================================================================================
+
+#ifdef STRINGPOOL_HAS_SNAPSHOT
+
+void BenchmarkSnapshot()
+{
+    cout << "\nReloading a pooled dictionary at startup...\n\n";
+
+    const vector<wstring> shuffled = BuildShuffledStrings();
+    const char* const kSnapshotPath = "StringPoolSnapshot.bin";
+
+    Stopwatch sw;
+
+    StringPool::Allocator poolAlloc;
+    vector<StringPool::String> strings;
+    sw.Start();
+    poolAlloc.AllocStrings(shuffled.data(), shuffled.size(), strings);
+    sw.Stop();
+    sw.PrintTime("Rebuild the pool");
+
+    sw.Start();
+    StringPool::SaveSnapshot(kSnapshotPath, strings);
+    sw.Stop();
+    sw.PrintTime("Save snapshot   ");
+
+    {
+        sw.Start();
+        StringPool::Snapshot snapshot{ kSnapshotPath };
+        sw.Stop();
+        sw.PrintTime("Load snapshot   ");
+
+        // Sanity check
+        if (snapshot.Strings() != strings)
+        {
+            throw runtime_error("Snapshot strings differ.");
+        }
+    }
+
+    std::remove(kSnapshotPath);
+}
+
+#endif // STRINGPOOL_HAS_SNAPSHOT
+
+
+//========================================================================================
+//                      Shared Pool Benchmark
+//========================================================================================
+
+#ifdef STRINGPOOL_HAS_SHARED_POOL
+
+void BenchmarkSharedPool()
+{
+    cout << "\nSharing a pooled dictionary among worker processes...\n\n";
+
+    const vector<wstring> shuffled = BuildShuffledStrings();
+    const char* const kSharedPoolName = "/StringPoolBenchmark";
+
+    Stopwatch sw;
+
+    StringPool::Allocator poolAlloc;
+    vector<StringPool::String> strings;
+    poolAlloc.AllocStrings(shuffled.data(), shuffled.size(), strings);
+
+    // Each worker holding its own copy
+    {
+        StringPool::Allocator workerAlloc;
+        vector<StringPool::String> workerStrings;
+        sw.Start();
+        workerAlloc.AllocStrings(shuffled.data(), shuffled.size(), workerStrings);
+        sw.Stop();
+        sw.PrintTime("Worker copy          ");
+    }
+
+    StringPool::SharedPool::Remove(kSharedPoolName);
+
+    sw.Start();
+    StringPool::SharedPool producer = 
+        StringPool::SharedPool::Create(kSharedPoolName, strings);
+    sw.Stop();
+    sw.PrintTime("Create shared pool   ");
+
+    {
+        // Done by each worker process
+        sw.Start();
+        StringPool::SharedPool worker = StringPool::SharedPool::Open(kSharedPoolName);
+        sw.Stop();
+        sw.PrintTime("Open shared pool     ");
+
+        // Sanity check
+        for (size_t i = 0; i < strings.size(); ++i)
+        {
+            if (worker[i] != strings[i] || worker.Resolve(producer.Handle(i)) != strings[i])
+            {
+                StringPool::SharedPool::Remove(kSharedPoolName);
+                throw runtime_error("Shared pool strings differ.");
+            }
+        }
+    }
+
+    StringPool::SharedPool::Remove(kSharedPoolName);
+}
+
+#endif // STRINGPOOL_HAS_SHARED_POOL
+
+
+//========================================================================================
+//                                  Sanity Checks
+//========================================================================================
+
+// Throw if a sanity check fails.
+void Check(bool condition, const char* message)
+{
+    if (!condition)
+    {
+        throw runtime_error(message);
+    }
+}
+
+// Collects the data reported by HistogramInstrumentation.
+class TestInstrumentationCallback : public StringPool::InstrumentationCallback
+{
+public:
+    size_t ChunkCount = 0;
+    size_t ChunkBytes = 0;
+    map<size_t, uint64_t> Buckets;
+
+    void OnChunkAllocated(size_t chunkSizeInBytes, chrono::nanoseconds) override
+    {
+        ++ChunkCount;
+        ChunkBytes += chunkSizeInBytes;
+    }
+
+    void OnStringLengthBucket(size_t bucket, uint64_t count) override
+    {
+        Buckets[bucket] = count;
+    }
+};
+
+void CheckInstrumentation()
+{
+    cout << "Checking the allocation instrumentation...\n";
+
+    typedef StringPool::BasicAllocator<wchar_t, StringPool::HistogramInstrumentation> 
+        InstrumentedAllocator;
+
+    TestInstrumentationCallback callback;
+    InstrumentedAllocator poolAlloc;
+    StringPool::HistogramInstrumentation& stats = poolAlloc.GetInstrumentation();
+    stats.SetCallback(&callback);
+
+    // Known lengths: 0, 1 (x3), 2..3 (x2), 64..127, in the first chunk
+    poolAlloc.AllocString(L"");
+    poolAlloc.AllocString(L"a");
+    poolAlloc.AllocString(L"b");
+    poolAlloc.AllocString(L"c");
+    poolAlloc.AllocString(L"de");
+    poolAlloc.AllocString(L"fgh");
+    const wstring text(100, L'x');
+    poolAlloc.AllocString(text.c_str());
+
+    // A string that doesn't fit in the first chunk
+    const wstring longText(1000 * 1000, L'y');
+    poolAlloc.AllocString(longText.c_str());
+
+    Check(stats.BucketCount(0) == 1 && stats.BucketCount(1) == 3 
+          && stats.BucketCount(2) == 2 && stats.BucketCount(7) == 1
+          && stats.BucketCount(StringPool::HistogramInstrumentation::BucketIndex(
+                 longText.size())) == 1,
+          "Wrong string length histogram.");
+
+    Check(stats.ChunkAllocCount() == 2 && callback.ChunkCount == 2
+          && callback.ChunkBytes == poolAlloc.AllocatedBytes(),
+          "Wrong chunk allocation count.");
+    Check(stats.SlowPathTime() > chrono::nanoseconds::zero(), 
+          "The chunk allocation slow path has not been timed.");
+
+    stats.ReportHistogram();
+    Check(callback.Buckets.size() == 5 && callback.Buckets[1] == 3,
+          "Wrong histogram reported to the callback.");
+
+    stats.Reset();
+    Check(stats.BucketCount(1) == 0 && stats.ChunkAllocCount() == 0,
+          "Instrumentation data not reset.");
+}
+
+void CheckBudget()
+{
+    cout << "Checking the memory budget...\n";
+
+    StringPool::BasicAllocator<char> poolAlloc;
+    int softLimitCalls = 0;
+    poolAlloc.SetBudget(1000 * 1000, 2000 * 1000, [&](size_t allocatedBytes, size_t softLimit)
+    {
+        ++softLimitCalls;
+        Check(allocatedBytes > softLimit, "Soft limit callback before crossing the limit.");
+    });
+
+    // Fill the pool up to the hard limit (several chunks past the soft limit)
+    const string text(200 * 1000, 'x');
+    vector<StringPool::BasicString<char>> strings;
+    StringPool::AllocError error = StringPool::AllocError::None;
+    for (;;)
+    {
+        const auto result = poolAlloc.TryAllocString(text.data(), text.data() + text.size());
+        if (!result)
+        {
+            error = result.Error();
+            break;
+        }
+        strings.push_back(result.Value());
+    }
+
+    Check(error == StringPool::AllocError::BudgetExceeded, 
+          "TryAllocString didn't report the exceeded budget.");
+    Check(softLimitCalls == 1, "The soft limit callback must be invoked once.");
+    Check(poolAlloc.AllocatedBytes() > 1000 * 1000 
+          && poolAlloc.AllocatedBytes() <= 2000 * 1000, 
+          "Wrong allocated bytes.");
+
+    // The failed allocations leave the pool unchanged
+    const size_t allocatedBytes = poolAlloc.AllocatedBytes();
+    bool thrown = false;
+    try
+    {
+        poolAlloc.AllocString(text.c_str());
+    }
+    catch (const StringPool::BudgetExceeded&)
+    {
+        thrown = true;
+    }
+
+    Check(thrown, "AllocString didn't throw BudgetExceeded.");
+    Check(poolAlloc.AllocatedBytes() == allocatedBytes && softLimitCalls == 1,
+          "Failed allocations changed the pool.");
+    for (const auto& s : strings)
+    {
+        Check(s.Length() == text.size() && text == s.Str(), "Wrong pooled strings.");
+    }
+
+    // Clear gives the whole budget back
+    poolAlloc.Clear();
+    Check(poolAlloc.AllocatedBytes() == 0, "Clear didn't release the budget.");
+    Check(poolAlloc.TryAllocString("abc").HasValue(), "Allocation failed after Clear.");
+}
+
+void CheckTryAllocation()
+{
+    cout << "Checking the non-throwing allocation functions...\n";
+
+    StringPool::Allocator poolAlloc;
+
+    const auto result = poolAlloc.TryAllocString(L"Connie");
+    Check(result.HasValue() && result.Error() == StringPool::AllocError::None
+          && result.Value().Str() == wstring(L"Connie"),
+          "TryAllocString failed.");
+#ifdef STRINGPOOL_HAS_STRING_VIEW
+    Check(poolAlloc.TryAllocString(wstring_view{ L"Connie" }).Value() == L"Connie",
+          "TryAllocString failed with a string view.");
+#endif
+
+    // Failures leave the pool unchanged
+    const size_t allocatedBytes = poolAlloc.AllocatedBytes();
+
+    const wstring tooLong(2 * 1024 * 1024, L'x');
+    const auto tooLongResult = poolAlloc.TryAllocString(tooLong.c_str());
+    Check(!tooLongResult && tooLongResult.Error() == StringPool::AllocError::StringTooLong
+          && tooLongResult.Value().IsEmpty(),
+          "TryAllocString didn't report the string too long.");
+
+    // A reservation larger than the address space
+    Check(poolAlloc.TryReserve(static_cast<size_t>(-1) / 2, 1) 
+          == StringPool::AllocError::OutOfMemory,
+          "TryReserve didn't report the out of memory.");
+    bool thrown = false;
+    try
+    {
+        poolAlloc.Reserve(static_cast<size_t>(-1) / 2, 1);
+    }
+    catch (const StringPool::BudgetExceeded&)
+    {
+    }
+    catch (const bad_alloc&)
+    {
+        thrown = true;
+    }
+    Check(thrown, "Reserve didn't throw std::bad_alloc.");
+
+    poolAlloc.SetBudget(0, poolAlloc.AllocatedBytes() + 1000);
+    Check(poolAlloc.TryReserve(1000 * 1000, 1) == StringPool::AllocError::BudgetExceeded,
+          "TryReserve didn't report the exceeded budget.");
+    const wstring large(500 * 1000, L'x');
+    Check(poolAlloc.TryAllocString(large.c_str()).Error() 
+          == StringPool::AllocError::BudgetExceeded,
+          "TryAllocString didn't report the exceeded budget.");
+
+    Check(poolAlloc.AllocatedBytes() == allocatedBytes && result.Value().Str() == wstring(L"Connie"),
+          "Failed allocations changed the pool.");
+
+    // Small strings still fit in the current chunk
+    Check(poolAlloc.TryAllocString(L"Isabella").HasValue(), 
+          "TryAllocString failed after a failure.");
+}
+
+void CheckReserve()
+{
+    cout << "Checking Reserve and ShrinkToFit...\n";
+
+    typedef StringPool::BasicAllocator<wchar_t, StringPool::HistogramInstrumentation> 
+        InstrumentedAllocator;
+
+    vector<wstring> source;
+    size_t totalChars = 0;
+    for (int i = 0; i < 100 * 1000; ++i)
+    {
+        source.push_back(L"key#" + to_wstring(i));
+        totalChars += source.back().size();
+    }
+
+    // Preload the pool, overestimating the sizes
+    InstrumentedAllocator poolAlloc;
+    poolAlloc.Reserve(2 * totalChars, source.size());
+    Check(poolAlloc.GetInstrumentation().ChunkAllocCount() == 1, 
+          "Reserve must allocate one chunk.");
+
+    vector<StringPool::String> strings;
+    for (const auto& s : source)
+    {
+        strings.push_back(poolAlloc.AllocString(s.c_str()));
+    }
+    Check(poolAlloc.GetInstrumentation().ChunkAllocCount() == 1, 
+          "Chunks allocated after Reserve.");
+
+    // Give the unused half back
+    const size_t allocatedBytes = poolAlloc.AllocatedBytes();
+    const size_t releasedBytes = poolAlloc.ShrinkToFit();
+    Check(releasedBytes != 0 && releasedBytes >= allocatedBytes / 4
+          && poolAlloc.AllocatedBytes() == allocatedBytes - releasedBytes,
+          "ShrinkToFit didn't release the unused memory.");
+    Check(poolAlloc.ShrinkToFit() == 0, "ShrinkToFit released memory twice.");
+
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        Check(strings[i].Str() == source[i], "Wrong strings after ShrinkToFit.");
+    }
+
+    // The next allocation goes into a new chunk
+    Check(poolAlloc.AllocString(L"Connie").Str() == wstring(L"Connie")
+          && poolAlloc.GetInstrumentation().ChunkAllocCount() == 2,
+          "Wrong allocation after ShrinkToFit.");
+}
+
+void CheckChunkLayout()
+{
+    cout << "Checking the chunk layout options...\n";
+
+    const size_t kPadding = 64;
+    const size_t kAlignment = 32;
+
+    StringPool::BasicAllocator<char, StringPool::HistogramInstrumentation> poolAlloc;
+    poolAlloc.SetTailPadding(kPadding);
+    poolAlloc.SetStringAlignment(kAlignment);
+
+    // Strings of varied lengths, spanning a few chunks
+    vector<StringPool::BasicString<char>> strings;
+    for (size_t i = 0; poolAlloc.GetInstrumentation().ChunkAllocCount() < 3; ++i)
+    {
+        const string s(1 + (i * 7) % 100, static_cast<char>('a' + i % 26));
+        strings.push_back(poolAlloc.AllocString(s.c_str()));
+    }
+
+    for (size_t i = 0; i < strings.size(); ++i)
+    {
+        const char* str = strings[i].Str();
+        const size_t length = strings[i].Length();
+        Check(reinterpret_cast<uintptr_t>(str) % kAlignment == 0, 
+              "Misaligned pooled string.");
+
+        // Zeros from the NUL to the start of the next string slot
+        const size_t slotLength = (length + kAlignment) / kAlignment * kAlignment;
+        for (size_t j = length; j < slotLength; ++j)
+        {
+            Check(str[j] == '\0', "Alignment padding not zeroed.");
+        }
+
+        // The last string of a chunk is followed by zeros up to the tail padding end
+        const bool isLastInChunk = (i + 1 == strings.size()) 
+            || (strings[i + 1].Str() != str + slotLength);
+        for (size_t j = length + 1; j < length + 1 + kPadding; ++j)
+        {
+            const char c = str[j];  // Readable
+            Check(!isLastInChunk || c == '\0', "Tail padding not zeroed.");
+        }
+    }
+}
+
+// Check that AllocStringFromUtf8 rejects 'utf8', both throwing and not throwing,
+// and that the rejected string takes no room in the pool.
+template <typename CharT>
+void CheckInvalidUtf8(StringPool::BasicAllocator<CharT>& poolAlloc, const string& utf8)
+{
+    const auto before = poolAlloc.AllocStringFromUtf8("a");
+
+    const auto result = poolAlloc.TryAllocStringFromUtf8(utf8.data(), 
+                                                         utf8.data() + utf8.size());
+    Check(!result && result.Error() == StringPool::AllocError::InvalidUtf8
+          && result.Value().IsEmpty(),
+          "TryAllocStringFromUtf8 accepted invalid UTF-8.");
+
+    bool thrown = false;
+    try
+    {
+        poolAlloc.AllocStringFromUtf8(utf8);
+    }
+    catch (const StringPool::InvalidUtf8&)
+    {
+        thrown = true;
+    }
+    Check(thrown, "AllocStringFromUtf8 didn't throw InvalidUtf8.");
+
+    const auto after = poolAlloc.AllocStringFromUtf8("b");
+    Check(after.Str() == before.Str() + 2, "Invalid UTF-8 took room in the pool.");
+}
+
+void CheckUtf8Validation()
+{
+    cout << "Checking the UTF-8 validation...\n";
+
+    const string invalid[] =
+    {
+        // Overlong encodings
+        "\xC0\x80", "\xC1\xBF", "\xE0\x80\x80", "\xE0\x9F\xBF", "\xF0\x80\x80\x80",
+        "\xF0\x8F\xBF\xBF",
+
+        // Lone surrogates (U+D800, U+DBFF, U+DC00, U+DFFF)
+        "\xED\xA0\x80", "\xED\xAF\xBF", "\xED\xB0\x80", "\xED\xBF\xBF",
+
+        // Truncated sequences
+        "\xC3", "\xE2\x82", "\xF0\x9F\x98", "abc\xE2\x82", "\xE2\x82" "abc",
+
+        // Code points above U+10FFFF
+        "\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\xF7\xBF\xBF\xBF",
+
+        // Stray bytes
+        "\x80", "\xBF", "\xFE", "\xFF",
+
+        // Invalid byte after an ASCII run, for the SIMD fast path
+        "0123456789abcdefghijklmnopqrstuvwxyz\xC0\x80",
+    };
+
+    StringPool::Allocator poolAlloc;
+    StringPool::BasicAllocator<char16_t> poolAlloc16;
+    StringPool::BasicAllocator<char> poolAlloc8;
+    for (const auto& utf8 : invalid)
+    {
+        CheckInvalidUtf8(poolAlloc, utf8);
+        CheckInvalidUtf8(poolAlloc16, utf8);
+        CheckInvalidUtf8(poolAlloc8, utf8);
+    }
+
+    // The boundaries of the valid ranges
+    const auto valid = poolAlloc16.AllocStringFromUtf8(
+        "\x7F" "\xC2\x80" "\xED\x9F\xBF" "\xEE\x80\x80" "\xF4\x8F\xBF\xBF");
+    Check(valid.Str() == u16string(u"\x7F\x80\uD7FF\uE000\U0010FFFF"),
+          "Valid UTF-8 rejected or wrongly transcoded.");
+}
+
+// Check that CompareIgnoreCase and CaseInsensitiveHash agree on strings
+// equal ignoring case.
+template <typename CharT>
+void CheckEqualIgnoringCase(StringPool::BasicAllocator<CharT>& poolAlloc, 
+                            const CharT* a, const CharT* b)
+{
+    const auto stringA = poolAlloc.AllocString(a);
+    const auto stringB = poolAlloc.AllocString(b);
+    const StringPool::CaseInsensitiveHash hash;
+    Check(StringPool::CompareIgnoreCase(stringA, stringB) == 0
+          && StringPool::CompareIgnoreCase(stringB, stringA) == 0
+          && hash(stringA) == hash(stringB),
+          "CompareIgnoreCase and CaseInsensitiveHash disagree.");
+
+    // The folded copies are equal, too
+    Check(poolAlloc.AllocStringFolded(a) == poolAlloc.AllocStringFolded(b),
+          "Folded copies of strings equal ignoring case differ.");
+}
+
+void CheckCaseInsensitive()
+{
+    cout << "Checking the case-insensitive functions...\n";
+
+    StringPool::Allocator poolAlloc;
+    CheckEqualIgnoringCase(poolAlloc, L"Hello, World!", L"hELLO, wORLD!");
+    CheckEqualIgnoringCase(poolAlloc, L"\u212A\u212Bngstr\u00F6m", L"k\u00E5NGSTR\u00D6M");
+    CheckEqualIgnoringCase(poolAlloc, L"GRO\u1E9E", L"gro\u00DF");
+    CheckEqualIgnoringCase(poolAlloc, L"\u03A3\u038A\u03A3\u03A5\u03A6\u039F\u03A3",   // Sisyphus
+                           L"\u03C3\u03AF\u03C3\u03C5\u03C6\u03BF\u03C2");
+    CheckEqualIgnoringCase(poolAlloc, L"\U00010400", L"\U00010428");
+
+    // In UTF-8, the folded strings may be shorter or longer than the source
+    StringPool::BasicAllocator<char> poolAlloc8;
+    CheckEqualIgnoringCase(poolAlloc8, "\xE2\x84\xAA" "elvin", "kELVIN");
+    CheckEqualIgnoringCase(poolAlloc8, "GRO\xE1\xBA\x9E", "gro\xC3\x9F");
+    CheckEqualIgnoringCase(poolAlloc8, "\xC8\xBA", "\xE2\xB1\xA5");
+
+    Check(StringPool::CompareIgnoreCase(poolAlloc8.AllocString("\xC4\xB0"), 
+                                        poolAlloc8.AllocString("i")) != 0,
+          "U+0130 has no simple case folding.");
+
+    // Long UTF-8 strings, whose worst-case folded length exceeds the maximum
+    // string length, but whose actual folded length doesn't
+    string kelvins;
+    string sharpSs;
+    for (int i = 0; i < 400 * 1000; ++i)
+    {
+        kelvins += "\xE2\x84\xAA";      // U+212A, folded to 'k'
+    }
+    for (int i = 0; i < 300 * 1000; ++i)
+    {
+        sharpSs += "\xE1\xBA\x9E";      // U+1E9E, folded to U+00DF
+    }
+
+    const auto foldedKelvins = poolAlloc8.AllocStringFolded(
+        kelvins.data(), kelvins.data() + kelvins.size());
+    Check(foldedKelvins.Str() == string(400 * 1000, 'k'), "Wrong long folded string.");
+
+    const auto foldedSharpSs = poolAlloc8.TryAllocStringFolded(
+        sharpSs.data(), sharpSs.data() + sharpSs.size());
+    Check(foldedSharpSs && foldedSharpSs.Value().Length() == 2 * 300 * 1000
+          && memcmp(foldedSharpSs.Value().Str(), "\xC3\x9F\xC3\x9F", 4) == 0
+          && memcmp(foldedSharpSs.Value().Str() + 2 * 300 * 1000 - 2, "\xC3\x9F", 2) == 0,
+          "Wrong long folded string.");
+    Check(StringPool::CompareIgnoreCase(foldedSharpSs.Value(), 
+                                        poolAlloc8.AllocString(sharpSs.c_str())) == 0,
+          "Long folded string not equal ignoring case to its source.");
+
+    // Too long, even when folded
+    const string tooLong(2 * 1024 * 1024, 'A');
+    Check(poolAlloc8.TryAllocStringFolded(tooLong.data(), tooLong.data() + tooLong.size())
+              .Error() == StringPool::AllocError::StringTooLong,
+          "TryAllocStringFolded didn't report the string too long.");
+}
+
+// Check that 'allocate' throws std::bad_alloc.
+template <typename Function>
+void CheckThrowsBadAlloc(Function allocate, const char* message)
+{
+    bool thrown = false;
+    try
+    {
+        allocate();
+    }
+    catch (const bad_alloc&)
+    {
+        thrown = true;
+    }
+    Check(thrown, message);
+}
+
+void CheckRawAllocation()
+{
+    cout << "Checking the raw memory allocation...\n";
+
+    StringPool::Allocator poolAlloc;
+    void* ptr = poolAlloc.AllocBytes(100, 64);
+    Check(ptr != nullptr && reinterpret_cast<uintptr_t>(ptr) % 64 == 0,
+          "Wrong raw memory block.");
+
+    // Sizes that overflow with the alignment padding
+    const size_t kMaxSize = static_cast<size_t>(-1);
+    CheckThrowsBadAlloc([&] { poolAlloc.AllocBytes(kMaxSize, 64); },
+                        "AllocBytes didn't throw on overflow.");
+    CheckThrowsBadAlloc([&] { poolAlloc.AllocBytes(kMaxSize - 8, 16); },
+                        "AllocBytes didn't throw on overflow.");
+
+    StringPool::StlAllocator<uint64_t> stlAlloc{ poolAlloc };
+    CheckThrowsBadAlloc([&] { (void)stlAlloc.allocate(kMaxSize / sizeof(uint64_t)); },
+                        "StlAllocator didn't throw on overflow.");
+
+#ifdef STRINGPOOL_HAS_PMR
+    StringPool::MemoryResource resource{ poolAlloc };
+    CheckThrowsBadAlloc([&] { (void)resource.allocate(kMaxSize - 8, 16); },
+                        "MemoryResource didn't throw on overflow.");
+#endif
+}
+
+
+#ifdef STRINGPOOL_HAS_SNAPSHOT
+
+bool FileExists(const char* path)
+{
+    std::FILE* file = fopen(path, "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    fclose(file);
+    return true;
+}
+
+void CheckSnapshotFile()
+{
+    cout << "Checking the snapshot file writes...\n";
+
+    const char* const kSnapshotPath = "StringPoolCheck.bin";
+    const char* const kTempPath = "StringPoolCheck.bin.tmp";
+
+    StringPool::Allocator poolAlloc;
+    vector<StringPool::String> strings;
+    strings.push_back(poolAlloc.AllocString(L"Connie"));
+    StringPool::SaveSnapshot(kSnapshotPath, strings);
+
+    // Overwrite the existing snapshot
+    strings.push_back(poolAlloc.AllocString(L"Peter"));
+    StringPool::SaveSnapshot(kSnapshotPath, strings);
+    Check(!FileExists(kTempPath), "Temporary snapshot file left behind.");
+    {
+        StringPool::Snapshot snapshot{ kSnapshotPath };
+        Check(snapshot.Strings() == strings, "Snapshot strings differ.");
+    }
+    std::remove(kSnapshotPath);
+
+    // Failed save: nothing is left at the target path
+    const char* const kBadPath = "NoSuchDirectory/StringPoolCheck.bin";
+    bool thrown = false;
+    try
+    {
+        StringPool::SaveSnapshot(kBadPath, strings);
+    }
+    catch (const StringPool::SnapshotError&)
+    {
+        thrown = true;
+    }
+    Check(thrown, "SaveSnapshot didn't report the failure.");
+    Check(!FileExists(kBadPath), "Failed snapshot left at the target path.");
+}
+
+#endif // STRINGPOOL_HAS_SNAPSHOT
+
+
+void CheckCompressedPoolTraining()
+{
+    cout << "Checking the compressed pool training...\n";
+
+    StringPool::Allocator poolAlloc;
+    vector<StringPool::String> sample;
+    sample.push_back(poolAlloc.AllocString(L"Connie Peter Connie Peter"));
+    sample.push_back(poolAlloc.AllocString(L"Peter Connie Peter Connie"));
+
+    StringPool::CompressedPool compressedPool;
+    compressedPool.Train(sample);
+    const auto connie = compressedPool.AllocString(sample[0]);
+    Check(compressedPool.Decompress(connie) == sample[0].Str(),
+          "Wrong decompressed string.");
+
+    // Retraining would change the decoding of the strings already in the pool
+    bool thrown = false;
+    try
+    {
+        compressedPool.Train(sample.data() + 1, 1);
+    }
+    catch (const logic_error&)
+    {
+        thrown = true;
+    }
+    Check(thrown, "Train didn't refuse a pool holding strings.");
+    Check(compressedPool.Decompress(connie) == sample[0].Str(),
+          "Refused training changed the symbol table.");
+
+    // Retraining after Clear is fine
+    compressedPool.Clear();
+    compressedPool.Train(sample.data() + 1, 1);
+    const auto peter = compressedPool.AllocString(sample[1]);
+    Check(compressedPool.Decompress(peter) == sample[1].Str(),
+          "Wrong decompressed string after retraining.");
+    Check(peter == compressedPool.AllocString(sample[1]),
+          "Compressed strings differ after retraining.");
+}
+
+
+void CheckHashMapErase()
+{
+    cout << "Checking the hash map erase and growth...\n";
+
+    StringPool::Allocator poolAlloc;
+    vector<StringPool::String> keys;
+    for (int i = 0; i < 4000; ++i)
+    {
+        keys.push_back(poolAlloc.AllocString((L"key" + to_wstring(i)).c_str()));
+    }
+
+    const size_t kHalf = keys.size() / 2;
+    StringPool::StringHashMap<int> map;
+    for (size_t i = 0; i < kHalf; ++i)
+    {
+        map.Insert(keys[i], static_cast<int>(i));
+    }
+
+    // Erase every other key, leaving tombstones on the probe sequences
+    for (size_t i = 0; i < kHalf; i += 2)
+    {
+        Check(map.Erase(keys[i]), "Erase didn't find the key.");
+    }
+    Check(!map.Erase(keys[0]), "Erase found an erased key.");
+    Check(map.Size() == kHalf / 2, "Wrong hash map size after Erase.");
+    for (size_t i = 0; i < kHalf; ++i)
+    {
+        const int* value = map.Find(keys[i]);
+        Check((i % 2 == 0) ? value == nullptr : (value != nullptr && *value == int(i)),
+              "Wrong hash map lookup after Erase.");
+    }
+
+    // Re-insert the erased keys with new values, then grow the map with the other
+    // half of the keys: the rehashes must purge the tombstones, and keep the values
+    for (size_t i = 0; i < kHalf; i += 2)
+    {
+        Check(map.Insert(keys[i], -static_cast<int>(i)).second,
+              "Insert didn't add an erased key.");
+    }
+    const size_t capacity = map.Capacity();
+    for (size_t i = kHalf; i < keys.size(); ++i)
+    {
+        map.Insert(keys[i], static_cast<int>(i));
+    }
+    Check(map.Capacity() > capacity, "The hash map didn't grow.");
+    Check(map.Size() == keys.size(), "Wrong hash map size after growth.");
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        const int* value = map.Find(keys[i]);
+        const int expected = (i < kHalf && i % 2 == 0) ? -int(i) : int(i);
+        Check(value != nullptr && *value == expected, "Wrong hash map lookup after growth.");
+    }
+
+    // Insert and erase churn with a bounded size: the tombstones are purged
+    // in place, without growing the map
+    StringPool::StringHashMap<int> churn;
+    churn.Reserve(100);
+    const size_t churnCapacity = churn.Capacity();
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        churn.Insert(keys[i], static_cast<int>(i));
+        if (i >= 50)
+        {
+            Check(churn.Erase(keys[i - 50]), "Erase didn't find the key.");
+        }
+    }
+    Check(churn.Capacity() == churnCapacity, "The tombstones made the hash map grow.");
+    Check(churn.Size() == 50, "Wrong hash map size after churn.");
+    for (size_t i = keys.size() - 50; i < keys.size(); ++i)
+    {
+        Check(churn.Contains(keys[i]), "Wrong hash map lookup after churn.");
+    }
+
+    CheckThrowsBadAlloc([&] { map.Reserve(static_cast<size_t>(-1)); },
+                        "Reserve didn't throw on overflow.");
+    Check(map.Size() == keys.size() && map.Contains(keys[0]),
+          "Failed Reserve changed the hash map.");
+}
+
+
+int main() 
+{
+    cout << "*** Testing String Performance (STL vs. Pool) ***\n\n";
+    cout << "by Giovanni Dicanio\n\n";
+
+    PrintTestConditions();
+
+    constexpr int kExitOk = 0;
+    constexpr int kExitError = 1;
+
+    try
+    {
+        CheckInstrumentation();
+        CheckBudget();
+        CheckTryAllocation();
+        CheckReserve();
+        CheckChunkLayout();
+        CheckUtf8Validation();
+        CheckCaseInsensitive();
+        CheckRawAllocation();
+        CheckCompressedPoolTraining();
+        CheckHashMapErase();
+#ifdef STRINGPOOL_HAS_SNAPSHOT
+        CheckSnapshotFile();
+#endif
+
+        Benchmark();
+        BenchmarkRandomKeySort();
+        BenchmarkParallelSort();
+        BenchmarkCompare();
+        BenchmarkCharTypes();
+        BenchmarkUtf8();
+        BenchmarkCaseFolding();
+#ifdef STRINGPOOL_HAS_PMR
+        BenchmarkMemoryResource();
+#endif
+        BenchmarkStlAllocator();
+#ifdef STRINGPOOL_HAS_STRING_VIEW
+        BenchmarkStringViewLookup();
+#endif
+        BenchmarkDictionary();
+        BenchmarkCompression();
+        BenchmarkArtIndex();
+        BenchmarkHashMap();
+        BenchmarkTokenizer();
+        BenchmarkLineReader();
+        BenchmarkMerge();
+#ifdef STRINGPOOL_HAS_SNAPSHOT
+        BenchmarkSnapshot();
+#endif
+#ifdef STRINGPOOL_HAS_SHARED_POOL
+        BenchmarkSharedPool();
+#endif
+    }
+    catch (const exception& e)
+    {
+        cout << "\n\n*** ERROR: " << e.what() << "\n\n";
+        return kExitError;
+    }
+
+    return kExitOk;
+}
+